@@ -1,3 +1,11 @@
+#ifdef _WIN32
+// Windows: memória do processo para os relatórios de estresse (precisa vir antes do GLFW)
+#define NOMINMAX
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#endif
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
@@ -5,11 +13,42 @@
 #include <cmath>
 #include <string>
 #include <random>
+#include <cstdint>
 #include <chrono>
 #include <map>
 #include <algorithm>
 #include <sstream>
 #include <iomanip>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+#include <limits>
+#include <queue>
+#include <functional>
+#include <array>
+#include <utility>
+#include <memory>
+#include <string_view>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdio>
+#include <new>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#if defined(_WIN32) || defined(__linux__)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#endif
 
 // Includes para FreeType
 #include <ft2build.h>
@@ -19,6 +58,282 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+// ===================== Profiler por zonas =====================
+
+// PROFILE_ZONE("nome") mede o bloco até o fim do escopo. Com --profile cada zona grava um evento
+// (nome, início, fim, thread) num anel global e o anel vira um trace do Chrome (chrome://tracing,
+// ui.perfetto.dev) na tecla P ou na saída. Desligado, a zona é um teste; compilado com -DNO_PROFILER
+// ela some por completo
+#ifndef NO_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)("" name)
+#else
+#define PROFILE_ZONE(name)
+#endif
+
+const size_t PROFILER_RING_EVENTS = 1 << 20; // ~32 MB, alocados só com o profiler ligado
+
+struct ProfileEvent {
+    const char* name; // Literal: só o ponteiro é guardado
+    uint64_t start;
+    uint64_t end;
+    uint32_t thread;
+};
+
+struct Profiler {
+    std::atomic<bool> enabled{false};
+    std::atomic<uint64_t> next{0};            // Total de eventos gravados; o anel guarda os últimos
+    std::vector<ProfileEvent> events;
+    std::string fileName = "perfil.json";
+    uint64_t startTicks = 0;                  // Relógio das zonas e steady_clock no início, para calibrar
+    std::chrono::steady_clock::time_point startTime;
+};
+
+Profiler profiler;
+thread_local uint32_t profilerThread = 0;     // Índice lógico: 0 na thread principal, i nos trabalhadores
+
+// Relógio das zonas: contador de ciclos quando disponível (poucos ns), senão steady_clock em ns
+inline uint64_t profilerTicks() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void enableProfiler(const std::string& fileName) {
+    if (!fileName.empty()) profiler.fileName = fileName;
+    profiler.events.resize(PROFILER_RING_EVENTS);
+    profiler.startTime = std::chrono::steady_clock::now();
+    profiler.startTicks = profilerTicks();
+    profiler.enabled = true;
+}
+
+struct ProfileZone {
+    const char* name;
+    uint64_t start;
+
+    explicit ProfileZone(const char* name)
+        : name(name), start(profiler.enabled.load(std::memory_order_relaxed) ? profilerTicks() : 0) {}
+
+    ~ProfileZone() {
+        if (start == 0) return;
+        uint64_t end = profilerTicks();
+        uint64_t index = profiler.next.fetch_add(1, std::memory_order_relaxed);
+        profiler.events[index & (PROFILER_RING_EVENTS - 1)] = {name, start, end, profilerThread};
+    }
+};
+
+// Grava o anel como trace do Chrome (eventos completos "X", em µs desde o início). Só com as threads de
+// trabalho paradas (entre frames ou na saída). Retorna quantos eventos foram escritos
+size_t writeProfilerTrace() {
+    if (!profiler.enabled) return 0;
+    double elapsedUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - profiler.startTime).count();
+    uint64_t elapsedTicks = profilerTicks() - profiler.startTicks;
+    double usPerTick = elapsedTicks > 0 ? elapsedUs / (double)elapsedTicks : 0.0;
+
+    FILE* file = std::fopen(profiler.fileName.c_str(), "w");
+    if (!file) {
+        std::cerr << "Não foi possível gravar o perfil em " << profiler.fileName << std::endl;
+        return 0;
+    }
+    uint64_t total = profiler.next.load();
+    uint64_t first = total > PROFILER_RING_EVENTS ? total - PROFILER_RING_EVENTS : 0;
+    uint32_t threads = 0;
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (uint64_t i = first; i < total; i++) {
+        const ProfileEvent& event = profiler.events[i & (PROFILER_RING_EVENTS - 1)];
+        threads = std::max(threads, event.thread + 1);
+        std::fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n",
+                     event.name, event.thread, (double)(int64_t)(event.start - profiler.startTicks) * usPerTick,
+                     (double)(event.end - event.start) * usPerTick);
+    }
+    for (uint32_t thread = 0; thread < threads; thread++) {
+        std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}},\n",
+                     thread, thread == 0 ? "principal" : "trabalhador", thread);
+    }
+    std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"modern_tower_defense\"}}\n]}\n");
+    std::fclose(file);
+    return (size_t)(total - first);
+}
+
+// Na saída do programa
+void saveProfilerTrace() {
+    if (!profiler.enabled) return;
+    size_t events = writeProfilerTrace();
+    std::cout << "Perfil: " << events << " eventos de " << profiler.next.load() << " em " << profiler.fileName << std::endl;
+}
+
+// ===================== Log assíncrono =====================
+
+// LOG_INFO("categoria", "formato", ...) formata a mensagem direto num registro de um anel MPSC sem
+// trava (fila limitada de Vyukov: cada registro tem um número de sequência) e volta. Uma thread
+// escritora esvazia o anel em stdout (avisos e erros em stderr) e só dá flush quando ele fica vazio.
+// Com o anel cheio a mensagem é descartada e contada: quem loga nunca espera. Cada linha leva tempo,
+// nível, categoria e thread; as mensagens usam campos chave=valor. Níveis abaixo de LOG_MIN_LEVEL
+// somem na compilação (-DLOG_MIN_LEVEL=LOG_LEVEL_WARN, por exemplo)
+enum LogLevel { LOG_LEVEL_DEBUG, LOG_LEVEL_INFO, LOG_LEVEL_WARN, LOG_LEVEL_ERROR };
+
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_AT(level, category, ...) \
+    do { if constexpr ((level) >= LOG_MIN_LEVEL) logMessage(level, "" category, __VA_ARGS__); } while (0)
+#define LOG_DEBUG(category, ...) LOG_AT(LOG_LEVEL_DEBUG, category, __VA_ARGS__)
+#define LOG_INFO(category, ...) LOG_AT(LOG_LEVEL_INFO, category, __VA_ARGS__)
+#define LOG_WARN(category, ...) LOG_AT(LOG_LEVEL_WARN, category, __VA_ARGS__)
+#define LOG_ERROR(category, ...) LOG_AT(LOG_LEVEL_ERROR, category, __VA_ARGS__)
+
+const char* const logLevelNames[] = {"DEBUG", "INFO", "AVISO", "ERRO"};
+
+const size_t LOG_RING_RECORDS = 1024; // Potência de 2; ~260 KB estáticos
+const size_t LOG_TEXT_BYTES = 232;    // Mensagens maiores são truncadas
+
+struct LogRecord {
+    std::atomic<uint64_t> sequence{0}; // == posição: livre; == posição + 1: pronto para a escritora
+    LogLevel level = LOG_LEVEL_INFO;
+    uint32_t thread = 0;
+    const char* category = "";         // Literal: só o ponteiro é guardado
+    double seconds = 0.0;
+    char text[LOG_TEXT_BYTES];
+};
+
+struct Logger {
+    LogRecord records[LOG_RING_RECORDS];
+    std::atomic<uint64_t> enqueuePosition{0};
+    uint64_t dequeuePosition = 0;             // Só a escritora (ou flushLog sem escritora) mexe
+    std::atomic<uint64_t> written{0};         // Registros já escritos
+    std::atomic<uint64_t> dropped{0};
+    uint64_t reportedDropped = 0;
+    std::atomic<bool> running{false};
+    std::thread writer;
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    Logger() {
+        for (size_t i = 0; i < LOG_RING_RECORDS; i++) records[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    ~Logger();
+};
+
+Logger logger;
+
+void logMessage(LogLevel level, const char* category, const char* format, ...) {
+    uint64_t position = logger.enqueuePosition.load(std::memory_order_relaxed);
+    LogRecord* record;
+    for (;;) {
+        record = &logger.records[position & (LOG_RING_RECORDS - 1)];
+        int64_t difference = (int64_t)(record->sequence.load(std::memory_order_acquire) - position);
+        if (difference == 0) {
+            if (logger.enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+        } else if (difference < 0) {
+            logger.dropped.fetch_add(1, std::memory_order_relaxed); // Anel cheio
+            return;
+        } else {
+            position = logger.enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    record->level = level;
+    record->thread = profilerThread;
+    record->category = category;
+    record->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - logger.startTime).count();
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(record->text, LOG_TEXT_BYTES, format, args);
+    va_end(args);
+    record->sequence.store(position + 1, std::memory_order_release);
+}
+
+// Escreve os registros prontos, em ordem; retorna se escreveu algum
+bool drainLog() {
+    bool wrote = false;
+    for (;;) {
+        LogRecord& record = logger.records[logger.dequeuePosition & (LOG_RING_RECORDS - 1)];
+        if (record.sequence.load(std::memory_order_acquire) != logger.dequeuePosition + 1) break;
+        std::fprintf(record.level >= LOG_LEVEL_WARN ? stderr : stdout, "[%10.3f] %-5s %s t%u: %s\n", record.seconds,
+                     logLevelNames[record.level], record.category, record.thread, record.text);
+        record.sequence.store(logger.dequeuePosition + LOG_RING_RECORDS, std::memory_order_release);
+        logger.dequeuePosition++;
+        logger.written.store(logger.dequeuePosition, std::memory_order_release);
+        wrote = true;
+    }
+    uint64_t dropped = logger.dropped.load(std::memory_order_relaxed);
+    if (dropped != logger.reportedDropped) {
+        std::fprintf(stderr, "[log] %llu mensagens descartadas (anel cheio)\n", (unsigned long long)(dropped - logger.reportedDropped));
+        logger.reportedDropped = dropped;
+        wrote = true;
+    }
+    if (wrote) std::fflush(stdout);
+    return wrote;
+}
+
+void startLogger() {
+    if (logger.running.exchange(true)) return;
+    logger.writer = std::thread([] {
+        while (logger.running.load(std::memory_order_acquire)) {
+            if (!drainLog()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        drainLog();
+    });
+}
+
+void stopLogger() {
+    if (!logger.running.exchange(false)) return;
+    logger.writer.join();
+}
+
+Logger::~Logger() {
+    stopLogger();
+    drainLog();
+}
+
+// Espera a escritora alcançar tudo o que já foi logado; usada antes dos relatórios escritos direto em
+// std::cout, para não intercalar
+void flushLog() {
+    if (!logger.running.load()) {
+        drainLog();
+        return;
+    }
+    uint64_t target = logger.enqueuePosition.load();
+    while (logger.written.load(std::memory_order_acquire) < target) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+// ===================== Contadores de render =====================
+
+// Draw calls e trocas de estado (binds de programa, VAO, buffer e textura) do frame, para o HUD de
+// desempenho. As chamadas do glad são redefinidas aqui, antes de qualquer código GL, e cada uma passa
+// a somar no contador; o custo é um incremento por chamada
+struct RenderStats {
+    long long drawCalls = 0;
+    long long stateChanges = 0;
+    long long lastDrawCalls = 0;     // Do frame anterior, o que o HUD mostra
+    long long lastStateChanges = 0;
+
+    void endFrame() {
+        lastDrawCalls = drawCalls;
+        lastStateChanges = stateChanges;
+        drawCalls = 0;
+        stateChanges = 0;
+    }
+};
+
+RenderStats renderStats;
+
+#undef glDrawArrays
+#define glDrawArrays(...) (renderStats.drawCalls++, glad_glDrawArrays(__VA_ARGS__))
+#undef glUseProgram
+#define glUseProgram(...) (renderStats.stateChanges++, glad_glUseProgram(__VA_ARGS__))
+#undef glBindVertexArray
+#define glBindVertexArray(...) (renderStats.stateChanges++, glad_glBindVertexArray(__VA_ARGS__))
+#undef glBindBuffer
+#define glBindBuffer(...) (renderStats.stateChanges++, glad_glBindBuffer(__VA_ARGS__))
+#undef glBindTexture
+#define glBindTexture(...) (renderStats.stateChanges++, glad_glBindTexture(__VA_ARGS__))
+
 // Estruturas
 #ifndef POINT_STRUCT_DEFINED
 #define POINT_STRUCT_DEFINED
@@ -82,14 +397,51 @@ Color hslToRgb(float h, float s, float l) {
       return Color(r, g, b);
 }
 
-// Definição de tipos de torres
+// Como o projétil chega ao alvo
+enum ProjectileMode : unsigned char {
+    PROJECTILE_HOMING,    // Persegue o alvo a cada tick
+    PROJECTILE_BALLISTIC  // Interceptação calculada no disparo; o dano é um evento agendado
+};
+
+// Efeito de estado aplicado pelo projétil da torre
+enum StatusEffect : unsigned char {
+    EFFECT_NONE,
+    EFFECT_SLOW,  // Componente Slow: effectStrength = multiplicador da velocidade
+    EFFECT_BURN   // Componente Burn: effectStrength = dano por tick
+};
+
+// Definição de tipos de torres (arquétipos imutáveis, indexados por TowerTypeId)
 struct TowerType {
-    std::string name;
+    const char* key;  // Identificador usado em arquivos e na linha de comando
+    const char* name; // Nome exibido na interface
     Color color;
     float cost;
     float damage;
     float range;
     int fireRate;
+    ProjectileMode projectileMode;
+    StatusEffect effect;
+    float effectStrength;
+    int effectDuration;  // Ticks
+};
+
+// Características de um tipo de inimigo. Os valores são constantes de compilação: os kernels de
+// movimento e dano são especializados por tipo e leem daqui sem custo em tempo de execução
+struct EnemyKindTraits {
+    const char* key;
+    const char* name;
+    float speedScale;     // Multiplicadores sobre a fórmula base da onda
+    float healthScale;
+    float rewardScale;
+    float radius;
+    float hue;            // < 0 = matiz aleatória
+    float saturation;
+    float armor;          // Fração do dano absorvida (0 = nenhuma)
+    float slowResistance; // Fração da lentidão ignorada (1 = imune)
+    bool flying;          // No modo labirinto voa direto para a saída, por cima das torres
+    int firstWave;        // Primeira onda em que aparece na composição
+    int spawnWeight;      // Peso na composição da onda (0 = só como chefe)
+    int bossEvery;        // Fecha as ondas múltiplas deste número (0 = nunca)
 };
 
 // Vertex Shader Source (para formas)
@@ -137,10 +489,132 @@ void main() {
 }
 )";
 
+// Vertex Shader para o overlay de posicionamento (quad texturizado na tela inteira)
+const char* overlayVertexShaderSource = R"(
+#version 330 core
+layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
+out vec2 TexCoords;
+uniform mat4 projection;
+void main() {
+    gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
+    TexCoords = vertex.zw;
+}
+)";
+
+// Fragment Shader para o overlay: células livres em verde, bloqueadas em vermelho
+const char* overlayFragmentShaderSource = R"(
+#version 330 core
+in vec2 TexCoords;
+out vec4 FragColor;
+uniform sampler2D occupancy;
+void main() {
+    float blocked = texture(occupancy, TexCoords).r;
+    FragColor = blocked > 0.0 ? vec4(0.9, 0.2, 0.2, 0.18) : vec4(0.2, 0.9, 0.3, 0.06);
+}
+)";
+
+// Atualização das partículas por transform feedback: sem rasterização, cada vértice é uma partícula
+// do anel. As posições do anel emitidas neste frame nascem do seu surto (direção e velocidade sorteadas
+// por hash da posição); as demais seguem com arrasto. 64 = MAX_PARTICLE_BURSTS
+const char* particleUpdateShaderSource = R"(
+#version 330 core
+layout (location = 0) in vec4 inMotion;   // xy posição, zw velocidade (px/s)
+layout (location = 1) in vec4 inColor;
+layout (location = 2) in vec2 inAgeLife;  // idade e duração (s)
+out vec4 outMotion;
+out vec4 outColor;
+out vec2 outAgeLife;
+uniform float dt;
+uniform int capacity;
+uniform int emitStart;
+uniform int emitCount;
+uniform int burstCount;
+uniform vec4 burstShape[64];  // xy origem, z velocidade máxima, w duração máxima
+uniform vec4 burstColor[64];
+uniform int burstFirst[64];   // Primeira partícula do surto, contada a partir de emitStart
+uniform uint seed;
+
+uint hash(uint x) {
+    x ^= x >> 16; x *= 0x7feb352du;
+    x ^= x >> 15; x *= 0x846ca68bu;
+    return x ^ (x >> 16);
+}
+
+float random01(uint x) {
+    return float(hash(x) & 0xffffffu) / 16777216.0;
+}
+
+void main() {
+    int offset = (gl_VertexID - emitStart + capacity) % capacity;
+    if (offset < emitCount) {
+        int burst = 0;
+        for (int i = 1; i < burstCount; i++) {
+            if (offset >= burstFirst[i]) burst = i;
+        }
+        uint key = hash(uint(gl_VertexID) ^ seed);
+        float angle = random01(key) * 6.2831853;
+        float speed = burstShape[burst].z * mix(0.2, 1.0, random01(key + 1u));
+        outMotion = vec4(burstShape[burst].xy, cos(angle) * speed, sin(angle) * speed);
+        outColor = burstColor[burst];
+        outAgeLife = vec2(0.0, burstShape[burst].w * mix(0.5, 1.0, random01(key + 2u)));
+        return;
+    }
+    vec2 velocity = inMotion.zw * exp(-4.0 * dt);
+    outMotion = vec4(inMotion.xy + velocity * dt, velocity);
+    outColor = inColor;
+    outAgeLife = vec2(inAgeLife.x + dt, inAgeLife.y);
+}
+)";
+
+// Desenho das partículas como pontos redondos que encolhem e somem ao fim da vida
+const char* particleVertexShaderSource = R"(
+#version 330 core
+layout (location = 0) in vec4 motion;
+layout (location = 1) in vec4 color;
+layout (location = 2) in vec2 ageLife;
+out vec4 particleColor;
+uniform mat4 projection;
+uniform float pointScale;
+void main() {
+    if (ageLife.x >= ageLife.y) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0); // Morta: fora do volume de recorte
+        gl_PointSize = 1.0;
+        particleColor = vec4(0.0);
+        return;
+    }
+    float t = ageLife.x / ageLife.y;
+    gl_Position = projection * vec4(motion.xy, 0.0, 1.0);
+    gl_PointSize = pointScale * (1.0 - 0.6 * t);
+    particleColor = vec4(color.rgb, color.a * (1.0 - t));
+}
+)";
+
+const char* particleFragmentShaderSource = R"(
+#version 330 core
+in vec4 particleColor;
+out vec4 FragColor;
+void main() {
+    vec2 d = gl_PointCoord * 2.0 - 1.0;
+    float r = dot(d, d);
+    if (r > 1.0) discard;
+    FragColor = vec4(particleColor.rgb, particleColor.a * (1.0 - r));
+}
+)";
+
 // Shader Program ID (para formas)
 unsigned int shaderProgram;
 unsigned int VBO, VAO;
 
+// Overlay de posicionamento (textura com o raster de ocupação)
+unsigned int overlayShaderProgram;
+unsigned int overlayVAO, overlayVBO;
+unsigned int placementTexture;
+
+// Malha do caminho: faixa de triângulos montada ao assar o caminho e enviada à GPU só quando muda
+unsigned int pathVAO, pathVBO;
+std::vector<float> pathMeshVertices;
+bool pathMeshDirty = true;
+
 // Variáveis para o tamanho da janela (agora são variáveis em vez de constantes)
 int WINDOW_WIDTH = 1000;
 int WINDOW_HEIGHT = 720;
@@ -154,11 +628,51 @@ const float TOWER_DAMAGE_BASIC = 01.0f;
 const float TOWER_DAMAGE_ADVANCED = 2.00f;
 const int TOWER_FIRE_RATE_BASIC = 10;
 const int TOWER_FIRE_RATE_ADVANCED = 50;
+const float TOWER_COST_FROST = 60.0f;
+const float TOWER_RANGE_FROST = 110.0f;
+const float TOWER_DAMAGE_FROST = 0.5f;
+const int TOWER_FIRE_RATE_FROST = 20;
+const float TOWER_SLOW_FACTOR = 0.5f;
+const int TOWER_SLOW_DURATION = 120;
+const float TOWER_COST_FIRE = 80.0f;
+const float TOWER_RANGE_FIRE = 130.0f;
+const float TOWER_DAMAGE_FIRE = 0.5f;
+const int TOWER_FIRE_RATE_FIRE = 40;
+const float TOWER_BURN_DAMAGE = 0.05f;
+const int TOWER_BURN_DURATION = 300;
 const float ENEMY_HEALTH_BASE = 60.0f;
 const float ENEMY_SPEED_BASE = 0.1f;
 const float ENEMY_REWARD_BASE = 10.0f;
 const int ENEMIES_PER_WAVE_BASE = 5;
 const int ENEMY_SPAWN_DELAY = 1000; // Reduzido de 700 para 60 (aproximadamente 1 segundo a 60 FPS)
+const int MAX_WAVES = 10; // Vitória ao completar esta onda
+const float PROJECTILE_SPEED = 6.0f;
+const float CROWD_LANE_HALF_WIDTH = 14.0f; // Afastamento máximo do centro do caminho com a separação de multidão
+
+// Parâmetros da simulação que os modos headless (avaliador, estresse) podem sobrescrever.
+// O jogo normal usa os valores padrão acima
+struct SimConfig {
+    float startMoney = 120.0f;
+    int startLives = 10;
+    int maxWaves = MAX_WAVES;
+    int enemiesPerWaveBase = ENEMIES_PER_WAVE_BASE;
+    int enemiesPerWaveGrowth = 2;  // Inimigos a mais por onda
+    int spawnDelay = ENEMY_SPAWN_DELAY;
+    float spawnJitter = 0.0f;      // Variação do intervalo entre lotes, em fração de spawnDelay, sorteada pela semente
+    int spawnBatch = 1;            // Inimigos gerados a cada spawn
+    float enemySpeedScale = 1.0f;
+    float projectileSpeed = PROJECTILE_SPEED;
+    bool mazeMode = false;         // Modo labirinto: inimigos seguem o flow field em vez do caminho fixo
+    int mazeCellSize = 16;         // Tamanho da célula do flow field em pixels
+    int projectileMode = -1;       // ProjectileMode para todas as torres; -1 = o de cada tipo
+    int enemyKind = 0;             // EnemyKind de todos os inimigos (0 = só normais); -1 = ondas mistas
+    bool crowdSeparation = false;  // Inimigos mantêm distância mínima e ultrapassam os mais lentos
+    float crowdSpacing = 20.0f;    // Distância mínima entre inimigos (px)
+    int crowdThreads = 1;          // Threads da consulta de vizinhos (1 = só a thread da simulação)
+    bool pathLod = true;           // Inimigos fora do alcance de todas as torres dormem e avançam analiticamente
+};
+
+SimConfig simConfig;
 
 // NOVAS CORES PARA UI E ELEMENTOS
 const Color COLOR_TEXT_UI = Color(0.9f, 0.9f, 0.9f);
@@ -169,910 +683,6251 @@ const Color COLOR_BUTTON_SELECTED = Color(0.4f, 0.8f, 1.0f, 0.9f);
 const Color COLOR_FEEDBACK_BG = Color(0.15f, 0.18f, 0.22f, 0.85f);
 const Color COLOR_GAMEOVER_BG = Color(0.1f, 0.1f, 0.1f, 0.9f);
 
-// Tipos de torres disponíveis
-std::map<std::string, TowerType> towerTypes = {
-    {"basic", {"Básica", Color(0.3f, 0.7f, 1.0f), TOWER_COST_BASIC, TOWER_DAMAGE_BASIC, TOWER_RANGE_BASIC, TOWER_FIRE_RATE_BASIC}},
-    {"advanced", {"Avançada", Color(1.0f, 0.6f, 0.2f), TOWER_COST_ADVANCED, TOWER_DAMAGE_ADVANCED, TOWER_RANGE_ADVANCED, TOWER_FIRE_RATE_ADVANCED}}
+// Tipos de torres disponíveis: tabela densa indexada pelo id do tipo
+enum TowerTypeId : unsigned char {
+    TOWER_BASIC,
+    TOWER_ADVANCED,
+    TOWER_FROST,
+    TOWER_FIRE,
+    TOWER_TYPE_COUNT
 };
+const int NO_TOWER_TYPE = -1;
 
-// Variáveis globais do jogo
-float money = 120.0f;
-int lives = 10;
-int currentWave = 0;
-std::string placingTowerType = "";
-bool waveInProgress = false;
-bool gameOver = false;
-int frameCount = 0;
-int lastEnemySpawnTime = 0;
-int enemiesLeftToSpawn = 0;
-std::mt19937 rng(std::chrono::steady_clock::now().time_since_epoch().count());
-
-// Caminho dos inimigos (será ajustado dinamicamente com base no tamanho da janela)
-std::vector<Point> path;
+const TowerType towerTypes[TOWER_TYPE_COUNT] = {
+    {"basic", "Básica", Color(0.3f, 0.7f, 1.0f), TOWER_COST_BASIC, TOWER_DAMAGE_BASIC, TOWER_RANGE_BASIC, TOWER_FIRE_RATE_BASIC, PROJECTILE_HOMING, EFFECT_NONE, 0.0f, 0},
+    {"advanced", "Avançada", Color(1.0f, 0.6f, 0.2f), TOWER_COST_ADVANCED, TOWER_DAMAGE_ADVANCED, TOWER_RANGE_ADVANCED, TOWER_FIRE_RATE_ADVANCED, PROJECTILE_HOMING, EFFECT_NONE, 0.0f, 0},
+    {"frost", "Gelo", Color(0.6f, 0.95f, 1.0f), TOWER_COST_FROST, TOWER_DAMAGE_FROST, TOWER_RANGE_FROST, TOWER_FIRE_RATE_FROST, PROJECTILE_HOMING, EFFECT_SLOW, TOWER_SLOW_FACTOR, TOWER_SLOW_DURATION},
+    {"fire", "Fogo", Color(1.0f, 0.3f, 0.15f), TOWER_COST_FIRE, TOWER_DAMAGE_FIRE, TOWER_RANGE_FIRE, TOWER_FIRE_RATE_FIRE, PROJECTILE_HOMING, EFFECT_BURN, TOWER_BURN_DAMAGE, TOWER_BURN_DURATION}
+};
 
-// Variáveis de interface
-std::string feedbackMessage = "";
-double mouseX = 0, mouseY = 0;
+// Converte a chave textual ("basic", "advanced") no id do tipo; NO_TOWER_TYPE se não existir.
+// Só usada ao ler arquivos e opções, nunca no loop do jogo
+int findTowerType(const std::string& key) {
+    for (int type = 0; type < TOWER_TYPE_COUNT; type++) {
+        if (key == towerTypes[type].key) return type;
+    }
+    return NO_TOWER_TYPE;
+}
 
-// Adicionar antes das funções que usam showFeedback
-std::string currentFeedback;
-float feedbackTimer = 0.0f;
+// Tipos de inimigos: tabela constexpr indexada por EnemyKind. Um tipo novo só precisa entrar aqui;
+// os laços por lote são gerados para cada entrada
+enum EnemyKind : unsigned char {
+    ENEMY_NORMAL,
+    ENEMY_FAST,
+    ENEMY_ARMORED,
+    ENEMY_FLYING,
+    ENEMY_BOSS,
+    ENEMY_KIND_COUNT
+};
+const int NO_ENEMY_KIND = -1;
+
+constexpr EnemyKindTraits enemyKinds[ENEMY_KIND_COUNT] = {
+    // key, nome, velocidade, vida, recompensa, raio, matiz, saturação, armadura, resist. lentidão, voa, onda, peso, chefe
+    {"normal", "Normal", 1.0f, 1.0f, 1.0f, 15.0f, -1.0f, 0.7f, 0.0f, 0.0f, false, 1, 6, 0},
+    {"fast", "Rápido", 1.8f, 0.6f, 1.0f, 12.0f, 55.0f, 0.9f, 0.0f, 0.0f, false, 2, 2, 0},
+    {"armored", "Blindado", 0.7f, 1.5f, 1.5f, 17.0f, 210.0f, 0.1f, 0.4f, 0.0f, false, 3, 1, 0},
+    {"flying", "Voador", 1.2f, 0.7f, 1.2f, 13.0f, 280.0f, 0.6f, 0.0f, 0.5f, true, 4, 1, 0},
+    {"boss", "Chefe", 0.5f, 12.0f, 10.0f, 25.0f, 0.0f, 0.85f, 0.25f, 1.0f, false, 1, 0, 5}
+};
 
-// Função para redimensionar o caminho quando a janela é redimensionada
-void updatePath() {
-    path.clear();
-    path = {
-        {0.0f, static_cast<float>(WINDOW_HEIGHT) / 2.0f},
-        {static_cast<float>(WINDOW_WIDTH) * 0.15f, static_cast<float>(WINDOW_HEIGHT) / 2.0f},
-        {static_cast<float>(WINDOW_WIDTH) * 0.15f, static_cast<float>(WINDOW_HEIGHT) * 0.14f},
-        {static_cast<float>(WINDOW_WIDTH) * 0.4f, static_cast<float>(WINDOW_HEIGHT) * 0.14f},
-        {static_cast<float>(WINDOW_WIDTH) * 0.4f, static_cast<float>(WINDOW_HEIGHT) * 0.56f},
-        {static_cast<float>(WINDOW_WIDTH) * 0.65f, static_cast<float>(WINDOW_HEIGHT) * 0.56f},
-        {static_cast<float>(WINDOW_WIDTH) * 0.65f, static_cast<float>(WINDOW_HEIGHT) / 2.0f},
-        {static_cast<float>(WINDOW_WIDTH), static_cast<float>(WINDOW_HEIGHT) / 2.0f}
-    };
+int findEnemyKind(const std::string& key) {
+    for (int kind = 0; kind < ENEMY_KIND_COUNT; kind++) {
+        if (key == enemyKinds[kind].key) return kind;
+    }
+    return NO_ENEMY_KIND;
 }
 
-// Callback para redimensionamento da janela - apenas declare o protótipo aqui
-void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+// Variáveis globais do jogo
+// O estado da simulação é thread_local: a janela usa a cópia da thread principal e
+// cada thread do avaliador headless roda a sua própria partida sem compartilhar nada
+thread_local float money = 120.0f;
+thread_local int lives = 10;
+thread_local int currentWave = 0;
+thread_local int placingTowerType = NO_TOWER_TYPE;
+thread_local bool waveInProgress = false;
+thread_local bool gameOver = false;
+thread_local int frameCount = 0;
+thread_local int lastEnemySpawnTime = 0;
+thread_local int enemiesLeftToSpawn = 0;
+thread_local unsigned int simulationSeed = (unsigned int)std::chrono::steady_clock::now().time_since_epoch().count();
+thread_local unsigned int nextEnemyId = 1; // Handles de inimigos (0 = nenhum alvo)
+
+// Números aleatórios baseados em contador (Philox4x32-10): cada sorteio é uma função pura de
+// (semente, fluxo, tick, entidade, índice), sem estado compartilhado. Qualquer thread sorteia sem
+// travas e o resultado não depende da ordem nem de como o trabalho foi dividido; o snapshot só
+// precisa guardar a semente
+enum RandomStream : unsigned int {
+    RANDOM_STREAM_ENEMY_COLOR = 1,
+    RANDOM_STREAM_SPAWN_JITTER = 2
+};
 
-void showFeedback(const std::string& message) {
-    currentFeedback = message;
-    feedbackTimer = 2.0f; // Mensagem ficará visível por 2 segundos
+std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> counter, uint32_t key0, uint32_t key1) {
+    for (int round = 0; round < 10; round++) {
+        uint64_t product0 = (uint64_t)0xD2511F53u * counter[0];
+        uint64_t product1 = (uint64_t)0xCD9E8D57u * counter[2];
+        counter = {(uint32_t)(product1 >> 32) ^ counter[1] ^ key0, (uint32_t)product1,
+                   (uint32_t)(product0 >> 32) ^ counter[3] ^ key1, (uint32_t)product0};
+        key0 += 0x9E3779B9u;
+        key1 += 0xBB67AE85u;
+    }
+    return counter;
 }
 
-// Classes do jogo
-class Enemy {
-public:
-    Point position;
-    int pathIndex;
-    float radius;
-    Color color;
-    float speed;
-    float maxHealth;
-    float health;
-    float reward;
+// Chave de um tick da simulação; é capturada na thread da simulação e pode ser passada às threads de trabalho
+struct RandomKey {
+    unsigned int seed;
+    unsigned int tick;
 
-    Enemy(int wave) {
-        position = path[0];
-        pathIndex = 0;
-        radius = 15.0f;
-        // Cor aleatória usando HSL, ajustada para ser mais vibrante
-        float hue = rng() % 360;
-        color = hslToRgb(hue, 0.7f, 0.6f); // Saturação e luminosidade ajustadas
-        speed = ENEMY_SPEED_BASE + (wave * 0.0005f * ENEMY_SPEED_BASE); // Ajuste mais sutil na velocidade
-        maxHealth = ENEMY_HEALTH_BASE + (wave * 15);
-        health = maxHealth;
-        reward = ENEMY_REWARD_BASE + (wave * 2);
+    unsigned int bits(RandomStream stream, unsigned int entity, unsigned int draw = 0) const {
+        return philox4x32({entity, tick, draw / 4, 0}, seed, stream)[draw % 4];
     }
 
-    void update() {
-        if (pathIndex < path.size() - 1) {
-            Point target = path[pathIndex + 1];
-            float dx = target.x - position.x;
-            float dy = target.y - position.y;
-            float distance = sqrt(dx * dx + dy * dy);
-
-            if (distance < speed) {
-                position = target;
-                pathIndex++;
-            } else {
-                position.x += (dx / distance) * speed;
-                position.y += (dy / distance) * speed;
-            }
-        } else {
-            lives--;
-            health = 0;
-            if (lives <= 0) {
-                gameOver = true;
-            }
-        }
+    // Uniforme em [0, 1) com 24 bits de mantissa
+    float unit(RandomStream stream, unsigned int entity, unsigned int draw = 0) const {
+        return (bits(stream, entity, draw) >> 8) * (1.0f / 16777216.0f);
     }
+};
 
-    void takeDamage(float amount) {
-        health -= amount;
-        if (health <= 0) {
-            money += reward;
-        }
-    }
+inline RandomKey randomKey() {
+    return {simulationSeed, (unsigned int)frameCount};
+}
+
+// Forma do caminho em coordenadas normalizadas (0.0-1.0); --path troca por uma lida de arquivo
+struct PathShape {
+    bool curved = false;               // Catmull-Rom pelos pontos de controle em vez de polilinha
+    std::vector<Point> controlPoints;
 };
 
-class Projectile {
-public:
-    Point position;
-    Enemy* target;
-    float radius;
-    Color color;
-    float speed;
-    float damage;
-    bool hasHit;
+PathShape pathShape = {false, {
+    {0.0f, 0.5f}, {0.15f, 0.5f}, {0.15f, 0.14f}, {0.4f, 0.14f},
+    {0.4f, 0.56f}, {0.65f, 0.56f}, {0.65f, 0.5f}, {1.0f, 0.5f}
+}};
 
-    Projectile(Point start, Enemy* target, float damage, Color color) {
-        position = start;
-        this->target = target;
-        radius = 5.0f;
-        this->color = color;
-        speed = 6.0f;
-        this->damage = damage;
-        hasHit = false;
-    }
-    
-    void update() {
-        if (hasHit || !target || target->health <= 0) {
-            damage = 0;
-            return;
-        }
+// Caminho dos inimigos, assado a partir de pathShape sempre que a janela muda de tamanho
+std::vector<Point> path;        // Polilinha tesselada (curvas viram segmentos de ~PATH_TESSELLATION_STEP px)
+std::vector<float> pathLengths; // Comprimento acumulado do caminho até cada ponto (pathLengths[0] = 0)
+std::vector<float> pathCorners; // Quinas onde o movimento encaixa: os vértices da polilinha, ou só as pontas da curva
+std::vector<unsigned int> pathLut; // Segmento de 'path' a cada PATH_LUT_STEP px de comprimento de arco
+const float PATH_TESSELLATION_STEP = 4.0f;
+const float PATH_LUT_STEP = 2.0f;
 
-        float dx = target->position.x - position.x;
-        float dy = target->position.y - position.y;
-        float distance = sqrt(dx * dx + dy * dy);
+// Variáveis de interface
+std::string feedbackMessage = "";
+double mouseX = 0, mouseY = 0;
 
-        if (distance < speed) {
-            target->takeDamage(damage);
-            hasHit = true;
-            damage = 0;
-        } else {
-            position.x += (dx / distance) * speed;
-            position.y += (dy / distance) * speed;
-        }
-    }
+// ===================== Roda de temporizadores =====================
+
+// Tipos de evento agendado
+enum TimerKind : unsigned char {
+    TIMER_TOWER_READY,       // Recarga da torre concluída (payload = índice da torre)
+    TIMER_SPAWN,             // Próximo lote de inimigos da onda
+    TIMER_PROJECTILE_IMPACT, // Impacto de projétil balístico (payload = posição em ballisticProjectiles)
+    TIMER_ENEMY_WAKE,        // Inimigo dormente se aproxima de um trecho coberto ou da saída (payload = id)
+    TIMER_FEEDBACK_EXPIRY    // Fim da mensagem de feedback (roda da interface, em ms)
 };
 
-class Tower {
-public:
-    Point position;         // Posição atual em pixels
-    Point normalizedPos;    // Posição normalizada (0.0-1.0)
-    std::string typeName;
-    TowerType typeDetails;
-    float radius;
-    float normalizedRadius; // Raio normalizado em relação à altura da janela
-    Color color;
-    float range;
-    float normalizedRange;  // Alcance normalizado em relação à altura da janela
-    float damage;
-    int fireRate;
-    int lastShotTime;
-    Enemy* target;
+struct TimerEvent {
+    long long due;
+    unsigned int payload;
+    unsigned char kind;
+};
 
-    Tower(float x, float y, const std::string& typeName) {
-        // Armazenar coordenadas normalizadas
-        normalizedPos.x = x / static_cast<float>(WINDOW_WIDTH);
-        normalizedPos.y = y / static_cast<float>(WINDOW_HEIGHT);
-        position = Point(x, y);
-        
-        this->typeName = typeName;
-        typeDetails = towerTypes[typeName];
-        
-        // Calcular raio normalizado (em relação à altura da janela)
-        normalizedRadius = 20.0f / static_cast<float>(WINDOW_HEIGHT);
-        radius = 20.0f;
-        
-        color = typeDetails.color;
-        
-        // Calcular alcance normalizado
-        normalizedRange = typeDetails.range / static_cast<float>(WINDOW_HEIGHT);
-        range = typeDetails.range;
-        
-        damage = typeDetails.damage;
-        fireRate = typeDetails.fireRate;
-        lastShotTime = 0;
-        target = nullptr;
+// Roda de temporizadores hierárquica: 4 níveis de 256 posições. O nível 0 tem uma posição por tick
+// e cada nível acima cobre 256x mais tempo; suas posições descem de nível quando o nível de baixo dá a volta.
+// Agendar e disparar custam O(1) e, sem eventos pendentes, avançar o tempo não custa nada.
+// Os eventos ficam num pool único com lista livre e cada posição é uma lista encadeada FIFO: o pool só
+// cresce até o pico de eventos pendentes, então a roda aquecida não aloca
+struct TimerWheel {
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 8;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const unsigned int NO_NODE = 0xFFFFFFFFu;
+
+    struct Node {
+        TimerEvent event;
+        unsigned int next;
+    };
+    struct List {
+        unsigned int head = NO_NODE;
+        unsigned int tail = NO_NODE;
+    };
+
+    std::vector<Node> nodes;
+    unsigned int freeNodes = NO_NODE;
+    List slots[LEVELS][SLOTS];
+    List overflow;                    // Além do alcance do último nível
+    long long now = 0;                // Próximo tick a ser processado
+    size_t pending = 0;
+
+    void reset(long long start) {
+        for (auto& level : slots) {
+            for (auto& slot : level) slot = List();
+        }
+        overflow = List();
+        nodes.clear();
+        freeNodes = NO_NODE;
+        now = start;
+        pending = 0;
     }
 
-    // Atualizar a posição e dimensões com base no tamanho atual da janela
-    void updateDimensions() {
-        position.x = normalizedPos.x * static_cast<float>(WINDOW_WIDTH);
-        position.y = normalizedPos.y * static_cast<float>(WINDOW_HEIGHT);
-        radius = normalizedRadius * static_cast<float>(WINDOW_HEIGHT);
-        range = normalizedRange * static_cast<float>(WINDOW_HEIGHT);
+    // Eventos no passado disparam no próximo tick processado
+    void schedule(long long due, TimerKind kind, unsigned int payload) {
+        pending++;
+        unsigned int node = freeNodes;
+        if (node != NO_NODE) {
+            freeNodes = nodes[node].next;
+        } else {
+            node = (unsigned int)nodes.size();
+            nodes.push_back(Node());
+        }
+        nodes[node].event = {std::max(due, now), payload, kind};
+        place(node);
     }
 
-    void findTarget(std::vector<Enemy>& enemies) {
-        target = nullptr;
-        float closestDistance = INFINITY;
-        
-        for (auto& enemy : enemies) {
-            if (enemy.health <= 0) continue;
+    // Avança o relógio sem disparar nada até o primeiro tick com eventos ou até 'limit'; retorna esse tick.
+    // O advance() seguinte começa nele (refazer a cascata do mesmo tick é inofensivo: place() recoloca
+    // cada evento pela distância até 'now')
+    long long skipToNextEvent(long long limit) {
+        while (now < limit) {
+            if (pending == 0) {
+                now = limit;
+                break;
+            }
+            for (int level = LEVELS - 1; level >= 1; level--) {
+                if ((now & ((1LL << (SLOT_BITS * level)) - 1)) == 0) cascade(level);
+            }
+            if (slots[0][now & (SLOTS - 1)].head != NO_NODE) break;
+            now++;
+        }
+        return now;
+    }
 
-            float dx = enemy.position.x - position.x;
-            float dy = enemy.position.y - position.y;
-            float distance = sqrt(dx * dx + dy * dy);
+    // Dispara, em ordem de tick, todos os eventos com vencimento até 'target' (inclusive)
+    template <typename Fire>
+    void advance(long long target, Fire&& fire) {
+        while (now <= target) {
+            if (pending == 0) {
+                now = target + 1;
+                return;
+            }
+            for (int level = LEVELS - 1; level >= 1; level--) {
+                if ((now & ((1LL << (SLOT_BITS * level)) - 1)) == 0) cascade(level);
+            }
 
-            if (distance < range) {
-                if (distance < closestDistance) {
-                    closestDistance = distance;
-                    target = &enemy;
+            // Eventos agendados para o tick atual durante o disparo também são disparados agora
+            List& slot = slots[0][now & (SLOTS - 1)];
+            while (slot.head != NO_NODE) {
+                unsigned int node = slot.head;
+                slot = List();
+                while (node != NO_NODE) {
+                    // Copiados antes de disparar: fire() pode agendar e realocar o pool
+                    TimerEvent event = nodes[node].event;
+                    unsigned int next = nodes[node].next;
+                    nodes[node].next = freeNodes;
+                    freeNodes = node;
+                    pending--;
+                    fire(event);
+                    node = next;
                 }
             }
+            now++;
         }
     }
 
-    void shoot(std::vector<Projectile>& projectiles, int frame) {
-        if (target && target->health > 0 && (frame - lastShotTime >= fireRate)) {
-            projectiles.emplace_back(position, target, damage, color);
-            lastShotTime = frame;
+private:
+    void append(List& list, unsigned int node) {
+        nodes[node].next = NO_NODE;
+        if (list.tail == NO_NODE) list.head = node;
+        else nodes[list.tail].next = node;
+        list.tail = node;
+    }
+
+    void place(unsigned int node) {
+        long long due = nodes[node].event.due;
+        long long delta = due - now;
+        for (int level = 0; level < LEVELS; level++) {
+            if (delta < (1LL << (SLOT_BITS * (level + 1)))) {
+                append(slots[level][(due >> (SLOT_BITS * level)) & (SLOTS - 1)], node);
+                return;
+            }
         }
+        append(overflow, node);
     }
 
-    void update(std::vector<Enemy>& enemies, std::vector<Projectile>& projectiles, int frame) {
-        findTarget(enemies);
-        shoot(projectiles, frame);
+    // Redistribui a posição do nível que vence agora pelos níveis de baixo
+    void cascade(int level) {
+        List& slot = slots[level][(now >> (SLOT_BITS * level)) & (SLOTS - 1)];
+        List moving = slot;
+        slot = List();
+        if (level == LEVELS - 1 && (now & ((1LL << (SLOT_BITS * LEVELS)) - 1)) == 0 && overflow.head != NO_NODE) {
+            if (moving.tail == NO_NODE) moving.head = overflow.head;
+            else nodes[moving.tail].next = overflow.head;
+            moving.tail = overflow.tail;
+            overflow = List();
+        }
+        for (unsigned int node = moving.head; node != NO_NODE;) {
+            unsigned int next = nodes[node].next;
+            place(node);
+            node = next;
+        }
     }
 };
 
-// Variáveis para as entidades do jogo
-std::vector<Enemy> enemies;
-std::vector<Tower> towers;
-std::vector<Projectile> projectiles;
+thread_local TimerWheel simTimers;                // Ticks da simulação (frameCount)
+thread_local TimerWheel uiTimers;                 // Milissegundos de tempo real da interface
+thread_local std::vector<unsigned int> readyTowers; // Torres com recarga concluída, aguardando alvo
 
-// Agora adicione a função updateTowerDimensions() aqui, depois da declaração de 'towers'
-void updateTowerDimensions() {
-    for (auto& tower : towers) {
-        tower.updateDimensions();
-    }
+// Adicionar antes das funções que usam showFeedback
+thread_local std::string currentFeedback;
+thread_local bool feedbackVisible = false;
+thread_local long long feedbackExpiresMs = 0;
+const int FEEDBACK_DURATION_MS = 2000;
+
+// Ponto da curva Catmull-Rom uniforme entre p1 e p2 (t em [0, 1])
+Point catmullRomPoint(const Point& p0, const Point& p1, const Point& p2, const Point& p3, float t) {
+    float t2 = t * t;
+    float t3 = t2 * t;
+    return Point(
+        0.5f * (2.0f * p1.x + (p2.x - p0.x) * t + (2.0f * p0.x - 5.0f * p1.x + 4.0f * p2.x - p3.x) * t2 + (3.0f * p1.x - p0.x - 3.0f * p2.x + p3.x) * t3),
+        0.5f * (2.0f * p1.y + (p2.y - p0.y) * t + (2.0f * p0.y - 5.0f * p1.y + 4.0f * p2.y - p3.y) * t2 + (3.0f * p1.y - p0.y - 3.0f * p2.y + p3.y) * t3));
+}
+
+void buildPathMesh();
+
+// Função para redimensionar o caminho quando a janela é redimensionada: assa pathShape uma vez
+// em polilinha, comprimentos acumulados, tabela de busca por comprimento de arco e malha de desenho
+void updatePath() {
+    std::vector<Point> control;
+    for (const auto& point : pathShape.controlPoints) {
+        control.push_back(Point(point.x * static_cast<float>(WINDOW_WIDTH), point.y * static_cast<float>(WINDOW_HEIGHT)));
+    }
+
+    path.clear();
+    if (pathShape.curved && control.size() >= 3) {
+        // Pontas fantasmas refletidas para a curva começar e terminar nos pontos extremos
+        size_t last = control.size() - 1;
+        Point before(2.0f * control[0].x - control[1].x, 2.0f * control[0].y - control[1].y);
+        Point after(2.0f * control[last].x - control[last - 1].x, 2.0f * control[last].y - control[last - 1].y);
+        path.push_back(control[0]);
+        for (size_t i = 0; i < last; i++) {
+            const Point& p0 = i == 0 ? before : control[i - 1];
+            const Point& p3 = i + 1 == last ? after : control[i + 2];
+            float chord = sqrt((control[i + 1].x - control[i].x) * (control[i + 1].x - control[i].x) +
+                               (control[i + 1].y - control[i].y) * (control[i + 1].y - control[i].y));
+            int steps = std::max(1, (int)ceil(chord / PATH_TESSELLATION_STEP));
+            for (int step = 1; step < steps; step++) {
+                path.push_back(catmullRomPoint(p0, control[i], control[i + 1], p3, (float)step / steps));
+            }
+            path.push_back(control[i + 1]);
+        }
+    } else {
+        path = control;
+    }
+
+    pathLengths.assign(path.size(), 0.0f);
+    for (size_t i = 1; i < path.size(); i++) {
+        float dx = path[i].x - path[i - 1].x;
+        float dy = path[i].y - path[i - 1].y;
+        pathLengths[i] = pathLengths[i - 1] + sqrt(dx * dx + dy * dy);
+    }
+
+    // Na curva não há quinas: o inimigo percorre o comprimento de arco inteiro sem encaixes
+    if (pathShape.curved && control.size() >= 3) pathCorners = {0.0f, pathLengths.back()};
+    else pathCorners = pathLengths;
+
+    // Entrada i guarda o segmento que contém o comprimento i·PATH_LUT_STEP
+    pathLut.assign((size_t)(pathLengths.back() / PATH_LUT_STEP) + 2, 0);
+    unsigned int segment = 0;
+    for (size_t i = 0; i < pathLut.size(); i++) {
+        float arc = i * PATH_LUT_STEP;
+        while (segment + 2 < path.size() && pathLengths[segment + 1] <= arc) segment++;
+        pathLut[i] = segment;
+    }
+
+    buildPathMesh();
+}
+
+// Segmento de 'path' que contém 'progress' em O(1): a tabela dá um segmento no máximo um passo
+// atrás, e os segmentos têm pelo menos ~PATH_LUT_STEP px na curva tesselada
+int pathSegmentAt(float progress) {
+    float slot = std::max(0.0f, std::min(progress * (1.0f / PATH_LUT_STEP), (float)(pathLut.size() - 1)));
+    unsigned int segment = pathLut[(size_t)slot];
+    while (segment + 2 < path.size() && pathLengths[segment + 1] <= progress) segment++;
+    return (int)segment;
+}
+
+// ===================== Cobertura do caminho pelas torres =====================
+
+// Trecho do caminho em comprimento de arco [start, end]
+struct PathInterval {
+    float start;
+    float end;
+};
+
+// Um círculo corta cada segmento em no máximo um trecho e trechos que se tocam nas quinas são unidos,
+// então a polilinha padrão gera no máximo (pontos - 1) intervalos; curvas costumam gerar poucos
+const int MAX_COVERAGE_INTERVALS = 8;
+const float COVERAGE_MARGIN = 1.0f; // Folga (px) para erros de arredondamento; o teste de distância exato vem depois
+
+// Calcula os trechos do caminho dentro de 'range' do ponto 'center'. Retorna quantos foram escritos
+int computePathCoverage(Point center, float range, PathInterval* out) {
+    int count = 0;
+    for (size_t i = 0; i + 1 < path.size(); i++) {
+        float length = pathLengths[i + 1] - pathLengths[i];
+        if (length <= 0.0f) continue;
+        float dirX = (path[i + 1].x - path[i].x) / length;
+        float dirY = (path[i + 1].y - path[i].y) / length;
+        float fx = path[i].x - center.x;
+        float fy = path[i].y - center.y;
+
+        // |f + t·dir|² = range²  =>  t² + 2bt + c = 0
+        float b = fx * dirX + fy * dirY;
+        float c = fx * fx + fy * fy - range * range;
+        float discriminant = b * b - c;
+        if (discriminant < 0.0f) continue;
+        float root = sqrt(discriminant);
+        float t0 = std::max(0.0f, -b - root);
+        float t1 = std::min(length, -b + root);
+        if (t0 > t1) continue;
+
+        float start = pathLengths[i] + t0 - COVERAGE_MARGIN;
+        float end = pathLengths[i] + t1 + COVERAGE_MARGIN;
+        if (count > 0 && start <= out[count - 1].end) {
+            out[count - 1].end = std::max(out[count - 1].end, end);
+        } else if (count < MAX_COVERAGE_INTERVALS) {
+            out[count++] = {start, end};
+        } else {
+            out[count - 1].end = end; // Caminho com mais segmentos que o previsto: amplia o último trecho
+        }
+    }
+    return count;
+}
+
+// Direção unitária do segmento que começa em path[segment]
+Point pathDirection(int segment) {
+    float length = pathLengths[segment + 1] - pathLengths[segment];
+    if (length <= 0.0f) return Point(1.0f, 0.0f);
+    return Point((path[segment + 1].x - path[segment].x) / length, (path[segment + 1].y - path[segment].y) / length);
+}
+
+// Movimentos que cabem no segmento antes do encaixe na quina 'end': menor m >= 0 com
+// end - (start + speed·m) < speed, na mesma aritmética do kernel de movimento (followPathRows)
+long long movesBeforeCorner(float start, float speed, float end) {
+    long long moves = std::max(0LL, (long long)((end - start) / speed) - 1);
+    while (!(end - (start + speed * (float)moves) < speed)) moves++;
+    while (moves > 0 && end - (start + speed * (float)(moves - 1)) < speed) moves--;
+    return moves;
+}
+
+// Ponto do caminho na distância 'progress' a partir do início
+Point pathPointAt(float progress) {
+    if (progress < 0.0f) return path.front();
+    if (progress >= pathLengths.back()) return path.back();
+    int i = pathSegmentAt(progress);
+    float length = pathLengths[i + 1] - pathLengths[i];
+    float t = length > 0.0f ? (progress - pathLengths[i]) / length : 0.0f;
+    return Point(path[i].x + (path[i + 1].x - path[i].x) * t, path[i].y + (path[i + 1].y - path[i].y) * t);
+}
+
+// Ponto do caminho deslocado 'lane' para o lado (separação de multidão)
+Point pathLanePointAt(float progress, float lane) {
+    Point point = pathPointAt(progress);
+    if (lane == 0.0f) return point;
+    Point direction = pathDirection(pathSegmentAt(progress));
+    return Point(point.x - direction.y * lane, point.y + direction.x * lane);
+}
+
+// Faixa de triângulos com PATH_DRAW_WIDTH de largura ao longo de 'path', com juntas em esquadria
+// (limitadas ao dobro da meia largura nas quinas fechadas). Desenhada numa única chamada
+const float PATH_DRAW_WIDTH = 5.0f;
+
+void buildPathMesh() {
+    pathMeshVertices.clear();
+    int lastSegment = (int)path.size() - 2;
+    for (int i = 0; i < (int)path.size(); i++) {
+        Point in = pathDirection(std::max(0, i - 1));
+        Point out = pathDirection(std::min(i, lastSegment));
+        Point normal(-(in.y + out.y), in.x + out.x);
+        float length = sqrt(normal.x * normal.x + normal.y * normal.y);
+        if (length < 1e-4f) {
+            normal = Point(-out.y, out.x); // Meia-volta: sem esquadria possível
+            length = 1.0f;
+        }
+        normal.x /= length;
+        normal.y /= length;
+        float cosine = normal.x * -out.y + normal.y * out.x; // Cosseno entre a esquadria e a normal do segmento
+        float half = PATH_DRAW_WIDTH * 0.5f / std::max(0.5f, cosine);
+        pathMeshVertices.insert(pathMeshVertices.end(), {
+            path[i].x + normal.x * half, path[i].y + normal.y * half,
+            path[i].x - normal.x * half, path[i].y - normal.y * half
+        });
+    }
+    pathMeshDirty = true;
+}
+
+// Callback para redimensionamento da janela - apenas declare o protótipo aqui
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void rebuildMapGrids();
+bool stepAlongFlowField(Point& position, float speed); // Modo labirinto
+
+// Mostra a mensagem por FEEDBACK_DURATION_MS. Só existe um evento de expiração pendente por vez:
+// mensagens novas apenas adiam o prazo, e o evento se reagenda se disparar antes dele
+// O texto é copiado para a capacidade que currentFeedback já tem: mensagens curtas não tocam no heap
+void showFeedback(std::string_view message) {
+    currentFeedback.assign(message.data(), message.size());
+    feedbackExpiresMs = uiTimers.now + FEEDBACK_DURATION_MS;
+    if (!feedbackVisible) {
+        uiTimers.schedule(feedbackExpiresMs, TIMER_FEEDBACK_EXPIRY, 0);
+    }
+    feedbackVisible = true;
+}
+
+// Avança a roda da interface até o instante atual (ms)
+void updateUiTimers(long long nowMs) {
+    uiTimers.advance(nowMs, [](const TimerEvent& event) {
+        if (event.kind != TIMER_FEEDBACK_EXPIRY) return;
+        if (event.due < feedbackExpiresMs) {
+            uiTimers.schedule(feedbackExpiresMs, TIMER_FEEDBACK_EXPIRY, 0);
+        } else {
+            feedbackVisible = false;
+        }
+    });
+}
+
+// ===================== Partículas: surtos emitidos pela simulação =====================
+
+// Impactos e mortes viram surtos de partículas. A simulação só anota o surto (posição, cor e tipo)
+// num buffer fixo por thread; o sistema de partículas da GPU consome os surtos no render. A emissão
+// só fica ligada na thread da janela com o sistema ativo, então as threads headless e os benchmarks
+// não pagam nada, e a simulação não lê nada daqui (o determinismo não muda)
+enum ParticleBurstKind : unsigned char {
+    PARTICLE_HIT,
+    PARTICLE_DEATH,
+    PARTICLE_BURST_KIND_COUNT
+};
+
+const int MAX_PARTICLE_BURSTS = 64; // Por frame; o excedente é descartado
+
+struct ParticleBurst {
+    Point position;
+    Color color;
+    ParticleBurstKind kind;
+};
+
+thread_local bool particleEmission = false;
+thread_local ParticleBurst particleBursts[MAX_PARTICLE_BURSTS];
+thread_local int particleBurstCount = 0;
+thread_local long long particleBurstsDropped = 0;
+
+inline void emitParticles(ParticleBurstKind kind, Point position, Color color) {
+    if (!particleEmission) return;
+    if (particleBurstCount == MAX_PARTICLE_BURSTS) {
+        particleBurstsDropped++;
+        return;
+    }
+    particleBursts[particleBurstCount++] = {position, color, kind};
+}
+
+// Classes do jogo
+// Estado quente do inimigo (movimento e vida), lido e escrito a cada tick pelos kernels por lote. Na
+// tabela cada campo é uma coluna própria (EnemyColumns); este registro só leva uma linha de um lugar
+// para outro (spawn, troca de tabela)
+struct EnemyState {
+    float progress;         // Distância percorrida ao longo do caminho (comprimento de arco)
+    float anchorProgress;   // Progresso no tick anchorTick; refeita nas quinas e quando a velocidade muda
+    float anchorSpeed;      // Velocidade desde a âncora (progress = anchorProgress + anchorSpeed·ticks)
+    int anchorTick;         // Primeiro tick cujo movimento parte de anchorProgress
+    float speed;
+    float health;
+    float reward;
+};
+
+// Estado inicial de um inimigo do tipo 'kind' na onda 'wave'
+EnemyState initialEnemyState(int wave, unsigned char kind) {
+    const EnemyKindTraits& traits = enemyKinds[kind];
+    EnemyState state;
+    state.progress = 0.0f;
+    state.speed = (ENEMY_SPEED_BASE + (wave * 0.0005f * ENEMY_SPEED_BASE)) * simConfig.enemySpeedScale * traits.speedScale; // Ajuste mais sutil na velocidade
+    state.health = (ENEMY_HEALTH_BASE + (wave * 15)) * traits.healthScale;
+    state.reward = (ENEMY_REWARD_BASE + (wave * 2)) * traits.rewardScale;
+    state.anchorProgress = 0.0f;
+    state.anchorSpeed = state.speed;
+    state.anchorTick = frameCount;
+    return state;
+}
+
+// Registro frio do inimigo: identidade, aparência e posição. O estado quente fica nas colunas da tabela
+class Enemy {
+public:
+    unsigned int id;        // Handle estável usado por torres e projéteis no lugar de ponteiros
+    Point position;
+    int pathIndex;
+    float radius;
+    Color color;
+    float maxHealth;
+    float lane;             // Separação de multidão: deslocamento lateral em relação ao centro do caminho
+    float crowdBrake;       // Separação de multidão: fração da velocidade neste tick (freia atrás de outro inimigo)
+    unsigned char kind;     // EnemyKind (também define a tabela do inimigo)
+
+    Enemy(int wave, unsigned char kind) {
+        const EnemyKindTraits& traits = enemyKinds[kind];
+        id = nextEnemyId++;
+        this->kind = kind;
+        position = path[0];
+        pathIndex = 0;
+        radius = traits.radius;
+        lane = 0.0f;
+        crowdBrake = 1.0f;
+        // Cor aleatória usando HSL, ajustada para ser mais vibrante (os tipos especiais têm matiz fixa)
+        float hue = (float)(randomKey().bits(RANDOM_STREAM_ENEMY_COLOR, id) % 360);
+        color = hslToRgb(traits.hue < 0.0f ? hue : traits.hue, traits.saturation, 0.6f);
+        maxHealth = (ENEMY_HEALTH_BASE + (wave * 15)) * traits.healthScale;
+    }
+
+    // Modo labirinto: segue o flow field. Retorna true ao chegar à saída
+    bool followFlowField(float speed) {
+        return stepAlongFlowField(position, speed);
+    }
+
+    // Modo labirinto, inimigos voadores: reto até a borda direita, por cima das torres
+    bool flyToExit(float speed) {
+        position.x += speed;
+        return position.x >= WINDOW_WIDTH;
+    }
+
+    // Posição a partir do progresso (deslocada 'lane' para o lado do segmento), pela tabela de busca
+    void placeOnPath(float progress) {
+        int segment = pathSegmentAt(progress);
+        Point direction = pathDirection(segment);
+        float along = progress - pathLengths[segment];
+        position.x = path[segment].x + direction.x * along - direction.y * lane;
+        position.y = path[segment].y + direction.y * along + direction.x * lane;
+    }
+};
+
+// Inimigos que chegaram ao fim do caminho neste lote: cada um custa uma vida
+void enemiesReachedExit(int count) {
+    if (count == 0) return;
+    lives -= count;
+    if (lives <= 0) {
+        gameOver = true;
+    }
+}
+
+// ===================== ECS de inimigos: tabelas por arquétipo =====================
+
+// Componentes opcionais de estado. Cada combinação de componentes (arquétipo) tem a sua tabela com
+// colunas contíguas: inimigos sem efeito ficam na tabela base e não pagam nada pelos efeitos
+struct Slow {
+    float factor;   // Multiplicador da velocidade
+    int untilTick;
+};
+
+// Multiplicador efetivo da lentidão, descontada a resistência do tipo de inimigo
+inline float slowFactorFor(float factor, float resistance) {
+    return factor + (1.0f - factor) * resistance;
+}
+
+struct Burn {
+    float damagePerTick;
+    int untilTick;
+};
+
+// Nível de detalhe do caminho: inimigo fora da cobertura de todas as torres. Não é movido por tick; o
+// estado é derivado da âncora (advanceEnemyTo) e um evento na roda o acorda em wakeTick
+struct Dormant {
+    int wakeTick;
+};
+
+enum ComponentBit : unsigned char {
+    COMPONENT_SLOW = 1 << 0,
+    COMPONENT_BURN = 1 << 1,
+    COMPONENT_DORMANT = 1 << 2
+};
+const int ENEMY_COMPONENT_SETS = 8; // Todas as combinações de COMPONENT_*
+const int ENEMY_ARCHETYPE_COUNT = ENEMY_KIND_COUNT * ENEMY_COMPONENT_SETS; // Tipo de inimigo x componentes
+
+template <typename T> struct ComponentTraits;
+template <> struct ComponentTraits<Slow> { static const unsigned char bit = COMPONENT_SLOW; };
+template <> struct ComponentTraits<Burn> { static const unsigned char bit = COMPONENT_BURN; };
+template <> struct ComponentTraits<Dormant> { static const unsigned char bit = COMPONENT_DORMANT; };
+
+template <typename... Components>
+constexpr unsigned char componentMask() {
+    return (unsigned char)(0 | ... | ComponentTraits<Components>::bit);
+}
+
+// Valores de todos os componentes opcionais (usado ao mover um inimigo de tabela)
+using EnemyComponentValues = std::tuple<Slow, Burn, Dormant>;
+
+// Estado quente em colunas (SoA), paralelas a EnemyTable::enemies: os kernels por lote percorrem
+// vetores contíguos de float em vez de saltar de Enemy em Enemy
+struct EnemyColumns {
+    std::vector<float> progress;
+    std::vector<float> anchorProgress;
+    std::vector<float> anchorSpeed;
+    std::vector<int> anchorTick;
+    std::vector<float> speed;
+    std::vector<float> health;
+    std::vector<float> reward;
+
+    // Chama fn(coluna) para cada coluna: cópias de linha, remoções e o snapshot tratam todas igual
+    template <typename Fn>
+    void forEachColumn(Fn&& fn) {
+        fn(progress);
+        fn(anchorProgress);
+        fn(anchorSpeed);
+        fn(anchorTick);
+        fn(speed);
+        fn(health);
+        fn(reward);
+    }
+
+    void push(const EnemyState& state) {
+        progress.push_back(state.progress);
+        anchorProgress.push_back(state.anchorProgress);
+        anchorSpeed.push_back(state.anchorSpeed);
+        anchorTick.push_back(state.anchorTick);
+        speed.push_back(state.speed);
+        health.push_back(state.health);
+        reward.push_back(state.reward);
+    }
+
+    EnemyState row(size_t row) const {
+        return {progress[row], anchorProgress[row], anchorSpeed[row], anchorTick[row], speed[row], health[row], reward[row]};
+    }
+};
+
+// Tabela de um arquétipo: as colunas Enemy e de estado sempre existem; as dos componentes só têm linhas
+// se o componente fizer parte da máscara. Um componente novo só precisa entrar aqui e em ComponentTraits
+struct EnemyTable {
+    unsigned char kind = 0; // EnemyKind de todas as linhas: cada tabela é um lote homogêneo
+    unsigned char mask = 0;
+    std::vector<Enemy> enemies;
+    EnemyColumns state;
+    std::tuple<std::vector<Slow>, std::vector<Burn>, std::vector<Dormant>> components;
+    std::vector<unsigned int> leavingRows; // Tabelas de dormentes: linhas acordadas desde a última compactação
+
+    template <typename T> std::vector<T>& column() { return std::get<std::vector<T>>(components); }
+    template <typename T> bool has() const { return (mask & ComponentTraits<T>::bit) != 0; }
+};
+
+// Índice da tabela do arquétipo (tipo, componentes)
+constexpr unsigned char enemyTableIndex(int kind, unsigned char mask) {
+    return (unsigned char)(kind * ENEMY_COMPONENT_SETS + mask);
+}
+
+// Tabela e linha de cada inimigo, indexadas pelo id
+struct EnemyLocation {
+    unsigned char table;
+    unsigned int row;
+};
+const unsigned char NO_ENEMY_TABLE = 0xFF;
+
+thread_local EnemyTable enemyTables[ENEMY_ARCHETYPE_COUNT];
+thread_local std::vector<EnemyLocation> enemyLocations;
+
+// Bit i ligado: enemyTables[i] tem linhas. Os sistemas por tick só visitam as tabelas ocupadas, então o
+// custo fixo do tick não cresce com o número de arquétipos (tipos x combinações de componentes)
+thread_local uint64_t occupiedEnemyTables = 0;
+static_assert(ENEMY_ARCHETYPE_COUNT <= 64, "occupiedEnemyTables tem um bit por tabela");
+
+inline int lowestSetBit(uint64_t bits) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (int)index;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+// Chama fn(EnemyTable&) para as tabelas ocupadas no início da chamada, em ordem de índice
+template <typename Fn>
+void forEachOccupiedTable(Fn&& fn) {
+    for (uint64_t bits = occupiedEnemyTables; bits != 0; bits &= bits - 1) {
+        fn(enemyTables[lowestSetBit(bits)]);
+    }
+}
+
+void updateTableOccupancy(int tableIndex) {
+    uint64_t bit = 1ull << tableIndex;
+    occupiedEnemyTables = enemyTables[tableIndex].enemies.empty() ? occupiedEnemyTables & ~bit : occupiedEnemyTables | bit;
+}
+
+// Mudanças estruturais ficam adiadas até flushEnemyCommands(), para que os sistemas possam
+// gerar/adicionar/remover componentes enquanto percorrem as tabelas
+struct EnemyCommand {
+    unsigned int id;
+    unsigned char addMask;
+    unsigned char removeMask;
+    EnemyComponentValues values;
+};
+
+// Inimigo gerado que ainda não entrou na tabela
+struct EnemySpawn {
+    Enemy enemy;
+    EnemyState state;
+};
+
+thread_local std::vector<EnemySpawn> pendingSpawns;
+thread_local std::vector<EnemyCommand> enemyCommands;
+
+void clearEnemyTables() {
+    for (int i = 0; i < ENEMY_ARCHETYPE_COUNT; i++) {
+        EnemyTable& table = enemyTables[i];
+        table.kind = (unsigned char)(i / ENEMY_COMPONENT_SETS);
+        table.mask = (unsigned char)(i % ENEMY_COMPONENT_SETS);
+        table.enemies.clear();
+        table.state.forEachColumn([](auto& column) { column.clear(); });
+        std::apply([](auto&... columns) { (columns.clear(), ...); }, table.components);
+        table.leavingRows.clear();
+    }
+    occupiedEnemyTables = 0;
+    enemyLocations.clear();
+    pendingSpawns.clear();
+    enemyCommands.clear();
+}
+
+size_t enemyCount() {
+    size_t count = 0;
+    forEachOccupiedTable([&](const EnemyTable& table) { count += table.enemies.size(); });
+    return count;
+}
+
+// Busca um inimigo pelo handle em O(1)
+Enemy* findEnemy(unsigned int id) {
+    if (id == 0 || id >= enemyLocations.size()) return nullptr;
+    const EnemyLocation& location = enemyLocations[id];
+    if (location.table == NO_ENEMY_TABLE) return nullptr;
+    return &enemyTables[location.table].enemies[location.row];
+}
+
+// Estado quente de um inimigo pelo handle (torres, projéteis e desenho; os sistemas por tabela leem as
+// colunas direto). Só vale para ids de inimigos presentes nas tabelas
+inline float& enemyHealth(unsigned int id) {
+    const EnemyLocation& location = enemyLocations[id];
+    return enemyTables[location.table].state.health[location.row];
+}
+
+inline float enemyProgress(unsigned int id) {
+    const EnemyLocation& location = enemyLocations[id];
+    return enemyTables[location.table].state.progress[location.row];
+}
+
+// Dano de um acerto, descontada a armadura do tipo (os kernels por lote descontam com a armadura constante)
+void damageEnemy(const Enemy& enemy, float amount) {
+    const EnemyLocation& location = enemyLocations[enemy.id];
+    EnemyColumns& state = enemyTables[location.table].state;
+    float& health = state.health[location.row];
+    health -= amount * (1.0f - enemyKinds[enemy.kind].armor);
+    if (health <= 0) {
+        money += state.reward[location.row];
+        emitParticles(PARTICLE_DEATH, enemy.position, enemy.color);
+    }
+}
+
+// Estado depois dos movimentos de todos os ticks anteriores a 'tick', com a velocidade da âncora
+// (inimigos dormentes do nível de detalhe). O(quinas atravessadas)
+void advanceEnemyTo(EnemyTable& table, size_t row, int tick) {
+    Enemy& enemy = table.enemies[row];
+    EnemyColumns& state = table.state;
+    float& anchorProgress = state.anchorProgress[row];
+    int& anchorTick = state.anchorTick[row];
+    const float anchorSpeed = state.anchorSpeed[row];
+    int last = (int)pathCorners.size() - 1;
+    while (enemy.pathIndex < last) {
+        long long moves = movesBeforeCorner(anchorProgress, anchorSpeed, pathCorners[enemy.pathIndex + 1]);
+        if (anchorTick + moves >= tick) break;
+        enemy.pathIndex++;
+        anchorProgress = pathCorners[enemy.pathIndex];
+        anchorTick += (int)moves + 1;
+    }
+    float& progress = state.progress[row];
+    progress = enemy.pathIndex < last ? anchorProgress + anchorSpeed * (float)(tick - anchorTick) : anchorProgress;
+    enemy.placeOnPath(progress);
+}
+
+// Consulta tipada: chama fn(Enemy&, Componentes&...) para cada inimigo que tem todos os componentes pedidos
+template <typename... Components, typename Fn>
+void forEachEnemy(Fn&& fn) {
+    const unsigned char required = componentMask<Components...>();
+    forEachOccupiedTable([&](EnemyTable& table) {
+        if ((table.mask & required) != required) return;
+        for (size_t row = 0; row < table.enemies.size(); row++) {
+            fn(table.enemies[row], table.template column<Components>()[row]...);
+        }
+    });
+}
+
+// Como forEachEnemy, mas só para os vivos (vida > 0 na coluna de estado)
+template <typename... Components, typename Fn>
+void forEachLiveEnemy(Fn&& fn) {
+    const unsigned char required = componentMask<Components...>();
+    forEachOccupiedTable([&](EnemyTable& table) {
+        if ((table.mask & required) != required) return;
+        const float* health = table.state.health.data();
+        for (size_t row = 0; row < table.enemies.size(); row++) {
+            if (health[row] > 0) fn(table.enemies[row], table.template column<Components>()[row]...);
+        }
+    });
+}
+
+template <typename T>
+void deferAddComponent(unsigned int id, const T& value) {
+    EnemyCommand command = {id, ComponentTraits<T>::bit, 0, EnemyComponentValues()};
+    std::get<T>(command.values) = value;
+    enemyCommands.push_back(command);
+}
+
+template <typename T>
+void deferRemoveComponent(unsigned int id) {
+    enemyCommands.push_back({id, 0, ComponentTraits<T>::bit, EnemyComponentValues()});
+}
+
+void setEnemyLocation(unsigned int id, unsigned char table, unsigned int row) {
+    if (id >= enemyLocations.size()) enemyLocations.resize(id + 1, {NO_ENEMY_TABLE, 0});
+    enemyLocations[id] = {table, row};
+}
+
+void insertEnemyRow(unsigned char tableIndex, const Enemy& enemy, const EnemyState& state, const EnemyComponentValues& values) {
+    EnemyTable& table = enemyTables[tableIndex];
+    setEnemyLocation(enemy.id, tableIndex, (unsigned int)table.enemies.size());
+    table.enemies.push_back(enemy);
+    table.state.push(state);
+    occupiedEnemyTables |= 1ull << tableIndex;
+    std::apply([&](auto&... columns) {
+        auto push = [&](auto& column) {
+            using T = typename std::decay_t<decltype(column)>::value_type;
+            if (table.mask & ComponentTraits<T>::bit) column.push_back(std::get<T>(values));
+        };
+        (push(columns), ...);
+    }, table.components);
+}
+
+// Dormentes só saem (ou morrem) depois de acordados, e a tabela não é percorrida por tick: em vez de
+// varrê-la, remove só as linhas acordadas, trocando cada uma pela última (a ordem não importa aqui)
+void compactDormantTable(EnemyTable& table) {
+    if (table.leavingRows.empty()) return;
+    std::sort(table.leavingRows.begin(), table.leavingRows.end(), std::greater<unsigned int>());
+    table.leavingRows.erase(std::unique(table.leavingRows.begin(), table.leavingRows.end()), table.leavingRows.end());
+    for (unsigned int row : table.leavingRows) {
+        Enemy& enemy = table.enemies[row];
+        if (table.state.health[row] > 0) continue;
+        if (enemy.id != 0) enemyLocations[enemy.id].table = NO_ENEMY_TABLE;
+        // Em ordem decrescente, a última linha nunca é uma das que ainda vão sair
+        size_t last = table.enemies.size() - 1;
+        if (row != last) {
+            enemy = table.enemies[last];
+            enemyLocations[enemy.id].row = row;
+        }
+        table.enemies.pop_back();
+        auto remove = [&](auto& column) {
+            if (column.empty()) return;
+            column[row] = column.back();
+            column.pop_back();
+        };
+        table.state.forEachColumn(remove);
+        std::apply([&](auto&... columns) { (remove(columns), ...); }, table.components);
+    }
+    table.leavingRows.clear();
+}
+
+// Remove as linhas de inimigos mortos e as já movidas para outra tabela, mantendo a ordem das demais.
+// Roda uma vez por tick, no fim de update()
+void compactEnemyTables() {
+    PROFILE_ZONE("compactEnemyTables");
+    for (uint64_t bits = occupiedEnemyTables; bits != 0; bits &= bits - 1) {
+        int tableIndex = lowestSetBit(bits);
+        EnemyTable& table = enemyTables[tableIndex];
+        if (table.has<Dormant>()) {
+            compactDormantTable(table);
+            updateTableOccupancy(tableIndex);
+            continue;
+        }
+        size_t kept = 0;
+        const float* health = table.state.health.data();
+        for (size_t row = 0; row < table.enemies.size(); row++) {
+            Enemy& enemy = table.enemies[row];
+            if (health[row] <= 0) {
+                if (enemy.id != 0) enemyLocations[enemy.id].table = NO_ENEMY_TABLE;
+                continue;
+            }
+            if (kept != row) {
+                table.enemies[kept] = enemy;
+                auto move = [&](auto& column) { if (!column.empty()) column[kept] = column[row]; };
+                table.state.forEachColumn(move);
+                std::apply([&](auto&... columns) { (move(columns), ...); }, table.components);
+                enemyLocations[enemy.id].row = (unsigned int)kept;
+            }
+            kept++;
+        }
+        table.enemies.erase(table.enemies.begin() + kept, table.enemies.end());
+        auto shrink = [&](auto& column) { if (!column.empty()) column.resize(kept); };
+        table.state.forEachColumn(shrink);
+        std::apply([&](auto&... columns) { (shrink(columns), ...); }, table.components);
+        updateTableOccupancy(tableIndex);
+    }
+}
+
+// Aplica as mudanças adiadas: novos inimigos entram na tabela sem componentes do seu tipo e quem
+// ganha ou perde um componente é copiado para a tabela do novo arquétipo (mesmo tipo). A linha antiga vira um inimigo morto
+// sem id, ignorado pelos sistemas e removido em compactEnemyTables()
+void flushEnemyCommands() {
+    PROFILE_ZONE("flushEnemyCommands");
+    for (const EnemySpawn& spawn : pendingSpawns) {
+        insertEnemyRow(enemyTableIndex(spawn.enemy.kind, 0), spawn.enemy, spawn.state, EnemyComponentValues());
+    }
+    pendingSpawns.clear();
+
+    for (const EnemyCommand& command : enemyCommands) {
+        Enemy* enemy = findEnemy(command.id);
+        if (!enemy || enemyHealth(command.id) <= 0) continue;
+        EnemyLocation location = enemyLocations[command.id];
+        EnemyTable& table = enemyTables[location.table];
+        unsigned char newMask = (unsigned char)((table.mask | command.addMask) & ~command.removeMask);
+
+        // Valores atuais dos componentes presentes; os adicionados pelo comando substituem (renovam) os antigos
+        EnemyComponentValues values;
+        std::apply([&](auto&... columns) {
+            auto read = [&](auto& column) {
+                using T = typename std::decay_t<decltype(column)>::value_type;
+                if (command.addMask & ComponentTraits<T>::bit) std::get<T>(values) = std::get<T>(command.values);
+                else if (!column.empty()) std::get<T>(values) = column[location.row];
+            };
+            (read(columns), ...);
+        }, table.components);
+
+        if (newMask == table.mask) {
+            std::apply([&](auto&... columns) {
+                auto write = [&](auto& column) {
+                    using T = typename std::decay_t<decltype(column)>::value_type;
+                    if (!column.empty()) column[location.row] = std::get<T>(values);
+                };
+                (write(columns), ...);
+            }, table.components);
+            continue;
+        }
+
+        Enemy moved = *enemy;
+        EnemyState movedState = table.state.row(location.row);
+        enemy->id = 0;
+        table.state.health[location.row] = 0;
+        insertEnemyRow(enemyTableIndex(table.kind, newMask), moved, movedState, values);
+    }
+    enemyCommands.clear();
+}
+
+// Efeito de estado do tipo de torre no inimigo atingido
+void applyHitEffects(const Enemy& enemy, unsigned char towerType) {
+    if (enemyHealth(enemy.id) <= 0) return;
+    const TowerType& details = towerTypes[towerType];
+    switch (details.effect) {
+        case EFFECT_SLOW:
+            deferAddComponent(enemy.id, Slow{details.effectStrength, frameCount + details.effectDuration});
+            break;
+        case EFFECT_BURN:
+            deferAddComponent(enemy.id, Burn{details.effectStrength, frameCount + details.effectDuration});
+            break;
+        default:
+            break;
+    }
+}
+
+// Velocidade efetiva do inimigo neste tick (com lentidão, se houver)
+float currentEnemySpeed(const Enemy& enemy) {
+    const EnemyLocation& location = enemyLocations[enemy.id];
+    EnemyTable& table = enemyTables[location.table];
+    const float speed = table.state.speed[location.row];
+    if (!table.has<Slow>()) return speed;
+    return speed * slowFactorFor(table.column<Slow>()[location.row].factor, enemyKinds[enemy.kind].slowResistance);
+}
+
+// Acorda um inimigo dormente: o estado atual vem da âncora e a volta para a tabela ativa fica adiada
+// (o inimigo é movido neste mesmo tick se acordar antes do sistema de movimento)
+void wakeEnemy(unsigned int id) {
+    const EnemyLocation& location = enemyLocations[id];
+    EnemyTable& table = enemyTables[location.table];
+    advanceEnemyTo(table, location.row, frameCount);
+    table.leavingRows.push_back(location.row);
+    deferRemoveComponent<Dormant>(id);
+}
+
+bool isEnemyDormant(unsigned int id) {
+    return enemyTables[enemyLocations[id].table].has<Dormant>();
+}
+
+// Projéteis continuam seguindo um alvo que saiu da cobertura e adormeceu: ele acorda antes de ser usado
+Enemy* findAwakeEnemy(unsigned int id) {
+    Enemy* enemy = findEnemy(id);
+    if (enemy && enemyHealth(id) > 0 && isEnemyDormant(id)) wakeEnemy(id);
+    return enemy;
+}
+
+class Projectile {
+public:
+    Point position;
+    unsigned int targetId;
+    float radius;
+    Color color;
+    float speed;
+    float damage;
+    bool hasHit;
+    unsigned char sourceType; // TowerTypeId de quem disparou (efeitos de estado)
+
+    Projectile(Point start, unsigned int targetId, float damage, Color color, unsigned char sourceType) {
+        position = start;
+        this->targetId = targetId;
+        radius = 5.0f;
+        this->color = color;
+        speed = simConfig.projectileSpeed;
+        this->damage = damage;
+        hasHit = false;
+        this->sourceType = sourceType;
+    }
+    
+    void update() {
+        Enemy* target = findAwakeEnemy(targetId);
+        if (hasHit || !target || enemyHealth(targetId) <= 0) {
+            damage = 0;
+            return;
+        }
+
+        float dx = target->position.x - position.x;
+        float dy = target->position.y - position.y;
+        float distance = sqrt(dx * dx + dy * dy);
+
+        if (distance < speed) {
+            emitParticles(PARTICLE_HIT, target->position, color);
+            damageEnemy(*target, damage);
+            applyHitEffects(*target, sourceType);
+            hasHit = true;
+            damage = 0;
+        } else {
+            position.x += (dx / distance) * speed;
+            position.y += (dy / distance) * speed;
+        }
+    }
+};
+
+// ===================== Projéteis balísticos =====================
+
+// Projétil balístico: o disparo (position é o ponto de disparo) mais a trajetória, que fica fora de
+// Projectile para não pesar no laço por tick dos teleguiados
+struct BallisticProjectile {
+    Projectile shot;
+    Point aim;      // Ponto de interceptação
+    int launchTick; // Tick do disparo
+    int impactTick; // Tick em que o dano é aplicado
+
+    // Posição para desenho, derivada do tempo de voo
+    Point positionAt(int frame) const {
+        if (impactTick <= launchTick) return shot.position;
+        float t = std::max(0.0f, std::min(1.0f, (frame - launchTick) / (float)(impactTick - launchTick)));
+        return Point(shot.position.x + (aim.x - shot.position.x) * t, shot.position.y + (aim.y - shot.position.y) * t);
+    }
+};
+
+// Projéteis balísticos não são atualizados por tick: ficam num pool de posições estáveis
+// (referenciadas pelos eventos de impacto); posições livres têm shot.hasHit = true
+thread_local std::vector<BallisticProjectile> ballisticProjectiles;
+thread_local std::vector<unsigned int> freeBallisticSlots;
+
+// Progresso do inimigo depois de mais 'ticks' chamadas de update(), reproduzindo o movimento
+// (avança 'speed' por tick e encaixa na quina quando falta menos que isso). Retorna false se ele
+// já tiver saído do mapa nesse instante. O(quinas restantes)
+bool predictEnemyProgress(const Enemy& enemy, float speed, long long ticks, float& progress) {
+    int index = enemy.pathIndex;
+    progress = enemyProgress(enemy.id);
+    int last = (int)pathCorners.size() - 1;
+    while (ticks > 0) {
+        if (index >= last) return false; // O próximo update() tira o inimigo do mapa
+        long long ticksToCorner = (long long)((pathCorners[index + 1] - progress) / speed) + 1;
+        if (ticks < ticksToCorner) {
+            progress += ticks * speed;
+            return true;
+        }
+        ticks -= ticksToCorner;
+        index++;
+        progress = pathCorners[index];
+    }
+    return true;
+}
+
+// Ticks até o update() em que o inimigo sai do mapa
+long long ticksUntilExit(const Enemy& enemy, float speed) {
+    long long ticks = 1;
+    float progress = enemyProgress(enemy.id);
+    for (int index = enemy.pathIndex; index + 1 < (int)pathCorners.size(); index++) {
+        ticks += (long long)((pathCorners[index + 1] - progress) / speed) + 1;
+        progress = pathCorners[index + 1];
+    }
+    return ticks;
+}
+
+// Menor k >= 1 tal que um projétil saindo de 'from' alcança o inimigo em k ticks (|E(k) - from| <= speed·k).
+// Com o projétil mais rápido que o inimigo a folga speed·k - |E(k) - from| só cresce, então a busca é binária;
+// senão ela não vale e retorna false (Tower::shoot atira teleguiado nesse caso).
+// A previsão usa a velocidade atual do inimigo (uma lentidão que mude durante o voo não é prevista)
+bool solveIntercept(const Enemy& enemy, Point from, float speed, int& ticks, Point& aim) {
+    float enemySpeed = currentEnemySpeed(enemy);
+    if (enemySpeed >= speed) return false;
+    auto reaches = [&](long long k, Point& point) {
+        float progress;
+        if (!predictEnemyProgress(enemy, enemySpeed, k, progress)) return false;
+        point = pathLanePointAt(progress, enemy.lane);
+        float dx = point.x - from.x;
+        float dy = point.y - from.y;
+        return dx * dx + dy * dy <= (speed * k) * (speed * k);
+    };
+
+    long long low = 1;
+    long long high = ticksUntilExit(enemy, enemySpeed) - 1; // Último instante em que o inimigo ainda está no mapa
+    Point point;
+    if (high < low || !reaches(high, point)) return false;
+    while (low < high) {
+        long long middle = low + (high - low) / 2;
+        if (reaches(middle, point)) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+    reaches(low, aim);
+    ticks = (int)low;
+    return true;
+}
+
+// Dispara um projétil balístico e agenda o impacto; retorna false se o alvo não pode ser alcançado
+bool launchBallisticProjectile(Point from, const Enemy& target, unsigned char towerType, int frame) {
+    int flightTicks;
+    Point aim;
+    if (!solveIntercept(target, from, simConfig.projectileSpeed, flightTicks, aim)) return false;
+
+    const TowerType& details = towerTypes[towerType];
+    BallisticProjectile projectile = {Projectile(from, target.id, details.damage, details.color, towerType),
+                                      aim, frame, frame + flightTicks};
+
+    unsigned int slot;
+    if (!freeBallisticSlots.empty()) {
+        slot = freeBallisticSlots.back();
+        freeBallisticSlots.pop_back();
+        ballisticProjectiles[slot] = projectile;
+    } else {
+        slot = (unsigned int)ballisticProjectiles.size();
+        ballisticProjectiles.push_back(projectile);
+    }
+    simTimers.schedule(projectile.impactTick, TIMER_PROJECTILE_IMPACT, slot);
+    return true;
+}
+
+// Evento de impacto: aplica o dano se o alvo ainda estiver vivo e libera a posição do pool
+void resolveBallisticImpact(unsigned int slot) {
+    Projectile& projectile = ballisticProjectiles[slot].shot;
+    Enemy* target = findAwakeEnemy(projectile.targetId);
+    if (target && enemyHealth(projectile.targetId) > 0) {
+        emitParticles(PARTICLE_HIT, target->position, projectile.color);
+        damageEnemy(*target, projectile.damage);
+        applyHitEffects(*target, projectile.sourceType);
+    }
+    projectile.hasHit = true;
+    projectile.damage = 0;
+    freeBallisticSlots.push_back(slot);
+}
+
+size_t ballisticProjectilesInFlight() {
+    return ballisticProjectiles.size() - freeBallisticSlots.size();
+}
+
+ProjectileMode projectileModeFor(int towerType) {
+    if (simConfig.mazeMode) return PROJECTILE_HOMING; // Sem caminho fixo não há trajetória a prever
+    if (simConfig.projectileMode >= 0) return (ProjectileMode)simConfig.projectileMode;
+    return towerTypes[towerType].projectileMode;
+}
+
+// Inimigos vivos ordenados por progresso no caminho, refeito a cada tick antes das torres.
+// Os ponteiros são estáveis durante a fase das torres (mudanças estruturais são adiadas) e ninguém
+// leva dano nela (os tiros só acertam depois), então quem entrou no índice continua vivo
+struct EnemyProgress {
+    float progress;
+    Enemy* enemy;
+
+    bool operator<(const EnemyProgress& other) const { return progress < other.progress; }
+};
+
+thread_local std::vector<EnemyProgress> enemiesByProgress;
+
+// Torre: só o estado da instância; cor, dano, cadência e custo vêm de towerTypes[type]
+class Tower {
+public:
+    Point position;         // Posição atual em pixels
+    Point normalizedPos;    // Posição normalizada (0.0-1.0)
+    float radius;
+    float normalizedRadius; // Raio normalizado em relação à altura da janela
+    float range;
+    float normalizedRange;  // Alcance normalizado em relação à altura da janela
+    int lastShotTime;
+    unsigned int targetId;
+    unsigned char type;     // TowerTypeId
+    unsigned char coverageCount;
+    PathInterval coverage[MAX_COVERAGE_INTERVALS]; // Trechos do caminho ao alcance (refeitos ao posicionar e redimensionar)
+
+    Tower(float x, float y, int type) {
+        // Armazenar coordenadas normalizadas
+        normalizedPos.x = x / static_cast<float>(WINDOW_WIDTH);
+        normalizedPos.y = y / static_cast<float>(WINDOW_HEIGHT);
+        position = Point(x, y);
+        
+        this->type = (unsigned char)type;
+        
+        // Calcular raio normalizado (em relação à altura da janela)
+        normalizedRadius = 20.0f / static_cast<float>(WINDOW_HEIGHT);
+        radius = 20.0f;
+        
+        // Calcular alcance normalizado
+        normalizedRange = towerTypes[type].range / static_cast<float>(WINDOW_HEIGHT);
+        range = towerTypes[type].range;
+        
+        lastShotTime = 0;
+        targetId = 0;
+        updateCoverage();
+    }
+
+    // Com a separação de multidão os inimigos andam até CROWD_LANE_HALF_WIDTH fora do centro do caminho
+    void updateCoverage() {
+        float reach = simConfig.crowdSeparation ? range + CROWD_LANE_HALF_WIDTH : range;
+        coverageCount = (unsigned char)computePathCoverage(position, reach, coverage);
+    }
+
+    // Atualizar a posição e dimensões com base no tamanho atual da janela
+    void updateDimensions() {
+        position.x = normalizedPos.x * static_cast<float>(WINDOW_WIDTH);
+        position.y = normalizedPos.y * static_cast<float>(WINDOW_HEIGHT);
+        radius = normalizedRadius * static_cast<float>(WINDOW_HEIGHT);
+        range = normalizedRange * static_cast<float>(WINDOW_HEIGHT);
+        updateCoverage();
+    }
+
+    // Considera um candidato vivo; empates de distância ficam com o menor id (mesma escolha da varredura completa)
+    void considerTarget(const Enemy& enemy, float& closestDistance) {
+        float dx = enemy.position.x - position.x;
+        float dy = enemy.position.y - position.y;
+        float distance = sqrt(dx * dx + dy * dy);
+
+        if (distance < range) {
+            if (distance < closestDistance || (distance == closestDistance && enemy.id < targetId)) {
+                closestDistance = distance;
+                targetId = enemy.id;
+            }
+        }
+    }
+
+    // Só olha os inimigos cujo progresso cai nos trechos cobertos (busca binária em enemiesByProgress)
+    void findTarget() {
+        targetId = 0;
+        float closestDistance = INFINITY;
+
+        for (int i = 0; i < coverageCount; i++) {
+            auto it = std::lower_bound(enemiesByProgress.begin(), enemiesByProgress.end(),
+                EnemyProgress{coverage[i].start, nullptr});
+            for (; it != enemiesByProgress.end() && it->progress <= coverage[i].end; ++it) {
+                considerTarget(*it->enemy, closestDistance);
+            }
+        }
+    }
+
+    // Varredura dos inimigos acordados (modo labirinto, onde não há caminho fixo, e ticks com poucas
+    // torres prontas). Dormentes estão fora da cobertura de todas as torres
+    void findTargetBruteForce() {
+        targetId = 0;
+        float closestDistance = INFINITY;
+
+        forEachOccupiedTable([&](EnemyTable& table) {
+            if (table.has<Dormant>()) return;
+            const float* health = table.state.health.data();
+            for (size_t row = 0; row < table.enemies.size(); row++) {
+                if (health[row] > 0) considerTarget(table.enemies[row], closestDistance);
+            }
+        });
+    }
+
+    // Só é chamada com a recarga concluída (a roda de temporizadores controla a cadência)
+    bool shoot(std::vector<Projectile>& projectiles, int frame) {
+        Enemy* target = findEnemy(targetId);
+        if (!target || enemyHealth(targetId) <= 0) return false;
+
+        // Alvo tão rápido quanto o projétil não tem interceptação prevista: o tiro sai teleguiado
+        if (projectileModeFor(type) == PROJECTILE_BALLISTIC && currentEnemySpeed(*target) < simConfig.projectileSpeed) {
+            if (!launchBallisticProjectile(position, *target, type, frame)) {
+                return false; // Inalcançável: continua pronta para outro alvo
+            }
+        } else {
+            const TowerType& details = towerTypes[type];
+            projectiles.emplace_back(position, targetId, details.damage, details.color, type);
+        }
+        lastShotTime = frame;
+        return true;
+    }
+
+    // Retorna true se atirou (a torre volta a recarregar). 'indexed': enemiesByProgress foi refeito neste tick
+    bool update(std::vector<Projectile>& projectiles, int frame, bool indexed) {
+        if (indexed) {
+            findTarget();
+        } else {
+            findTargetBruteForce();
+        }
+        return shoot(projectiles, frame);
+    }
+
+    long long readyTime() const {
+        return (long long)lastShotTime + towerTypes[type].fireRate;
+    }
+};
+
+// Variáveis para as entidades do jogo (os inimigos ficam em enemyTables)
+thread_local std::vector<Tower> towers;
+thread_local std::vector<Projectile> projectiles;
+
+// Agora adicione a função updateTowerDimensions() aqui, depois da declaração de 'towers'
+void updateTowerDimensions() {
+    for (auto& tower : towers) {
+        tower.updateDimensions();
+    }
+}
+
+// Novo tamanho de janela: caminho, torres e grades são refeitos em pixels
+void resizeWorld(int width, int height) {
+    WINDOW_WIDTH = width;
+    WINDOW_HEIGHT = height;
+    updatePath();
+    updateTowerDimensions();
+    rebuildMapGrids();
+}
+
+// Declarar protótipos de funções
+void setProjectionMatrix(unsigned int currentShaderProgram);
+void rebuildPathCoverage();
+void drawCircle(float x, float y, float radius, Color color);
+void drawRectangle(float x, float y, float width, float height, Color color);
+void drawLine(Point start, Point end, Color color, float width);
+void drawHexagon(float x, float y, float radius, Color color); // Novo protótipo
+void latchCursorEvents(bool reflected);
+void drawPlacementOverlay();
+void RenderText(std::string_view text, float x, float y_baseline, float scale, Color color);
+void initTextRendering();
+void initOpenGL();
+void drawPath();
+void drawPathInterval(const PathInterval& interval, Color color, float width);
+void drawEnemy(const Enemy& enemy, float health);
+void drawTower(const Tower& tower);
+void drawProjectile(const Projectile& projectile, Point position);
+void drawUI();
+void initGame();
+void spawnWave();
+void rebuildSimTimers();
+void startWave();
+bool canPlaceTower(float x, float y);
+void placeTower(float x, float y);
+void selectTowerType(int type);
+void update();
+void render();
+
+// ===================== Rastreamento de alocações =====================
+
+// Escopos marcados com AllocationScope; o resto conta como "outros" (instrumentação, eventos da janela)
+enum AllocationScopeTag {
+    ALLOC_SCOPE_OTHER,
+    ALLOC_SCOPE_UPDATE,
+    ALLOC_SCOPE_SPAWN,
+    ALLOC_SCOPE_RENDER,
+    ALLOC_SCOPE_UI,
+    ALLOC_SCOPE_COUNT
+};
+
+const char* const allocationScopeNames[ALLOC_SCOPE_COUNT] = {"outros", "update", "spawn", "render", "interface"};
+
+struct AllocationCounters {
+    long long allocations[ALLOC_SCOPE_COUNT] = {};
+    long long bytes[ALLOC_SCOPE_COUNT] = {};
+
+    long long taggedAllocations() const {
+        long long total = 0;
+        for (int tag = ALLOC_SCOPE_OTHER + 1; tag < ALLOC_SCOPE_COUNT; tag++) total += allocations[tag];
+        return total;
+    }
+    void add(const AllocationCounters& other) {
+        for (int tag = 0; tag < ALLOC_SCOPE_COUNT; tag++) {
+            allocations[tag] += other.allocations[tag];
+            bytes[tag] += other.bytes[tag];
+        }
+    }
+};
+
+// Os ganchos de operator new/delete estão sempre ativos, mas só contam com allocationTracking ligado
+// (--track-allocs, --alloc-check). O tamanho vem do próprio malloc (malloc_usable_size/_msize), sem
+// cabeçalho por bloco; liveHeapBytes é o saldo desde que o rastreamento ligou e pode ficar abaixo de
+// zero quando blocos antigos são liberados, por isso os relatórios o limitam a zero. Compilado com
+// -DALLOCATION_HEADERS (ou numa plataforma sem o tamanho do bloco), volta o cabeçalho de 16 bytes, que
+// desconta só o que foi contado. Os contadores são da thread que aloca, e os relatórios leem os da
+// thread principal
+#if !defined(ALLOCATION_HEADERS)
+#if defined(_WIN32)
+#define ALLOCATION_BLOCK_SIZE(block) _msize(block)
+#elif defined(__APPLE__)
+#define ALLOCATION_BLOCK_SIZE(block) malloc_size(block)
+#elif defined(__linux__)
+#define ALLOCATION_BLOCK_SIZE(block) malloc_usable_size(block)
+#else
+#define ALLOCATION_HEADERS
+#endif
+#endif
+
+// O delete fica fora de linha: inlinado, o GCC vê o free() num ponteiro vindo do new
+// (-Wmismatched-new-delete) e, com cabeçalho, a leitura antes do bloco (-Warray-bounds)
+#if defined(_MSC_VER)
+#define ALLOCATION_NOINLINE __declspec(noinline)
+#else
+#define ALLOCATION_NOINLINE __attribute__((noinline))
+#endif
+
+std::atomic<bool> allocationTracking{false};
+std::atomic<long long> liveHeapBytes{0};     // Saldo de bytes alocados com o rastreamento ligado
+std::atomic<long long> framePeakHeapBytes{0}; // Pico de liveHeapBytes desde o início do frame
+thread_local AllocationScopeTag allocationScope = ALLOC_SCOPE_OTHER;
+thread_local AllocationCounters frameAllocations;
+
+#ifdef ALLOCATION_HEADERS
+const size_t ALLOCATION_HEADER_BYTES = 16;
+#endif
+
+void countAllocation(long long size) {
+    frameAllocations.allocations[allocationScope]++;
+    frameAllocations.bytes[allocationScope] += size;
+    long long live = liveHeapBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    long long peak = framePeakHeapBytes.load(std::memory_order_relaxed);
+    while (live > peak && !framePeakHeapBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+void* operator new(std::size_t size) {
+#ifdef ALLOCATION_HEADERS
+    unsigned char* block = static_cast<unsigned char*>(std::malloc(size + ALLOCATION_HEADER_BYTES));
+    if (!block) throw std::bad_alloc();
+    size_t* header = reinterpret_cast<size_t*>(block);
+    header[0] = size;
+    header[1] = 0;
+    if (allocationTracking.load(std::memory_order_relaxed)) {
+        header[1] = 1; // Só o que foi contado é descontado no delete
+        countAllocation((long long)size);
+    }
+    return block + ALLOCATION_HEADER_BYTES;
+#else
+    void* block = std::malloc(size ? size : 1);
+    if (!block) throw std::bad_alloc();
+    if (allocationTracking.load(std::memory_order_relaxed)) countAllocation((long long)ALLOCATION_BLOCK_SIZE(block));
+    return block;
+#endif
+}
+
+ALLOCATION_NOINLINE void operator delete(void* pointer) noexcept {
+    if (!pointer) return;
+#ifdef ALLOCATION_HEADERS
+    unsigned char* block = static_cast<unsigned char*>(pointer) - ALLOCATION_HEADER_BYTES;
+    size_t* header = reinterpret_cast<size_t*>(block);
+    if (header[1]) liveHeapBytes.fetch_sub((long long)header[0], std::memory_order_relaxed);
+    std::free(block);
+#else
+    if (allocationTracking.load(std::memory_order_relaxed)) {
+        liveHeapBytes.fetch_sub((long long)ALLOCATION_BLOCK_SIZE(pointer), std::memory_order_relaxed);
+    }
+    std::free(pointer);
+#endif
+}
+
+ALLOCATION_NOINLINE void operator delete(void* pointer, std::size_t) noexcept {
+    operator delete(pointer);
+}
+
+// Marca as alocações feitas durante a vida do objeto (aninhável)
+struct AllocationScope {
+    AllocationScopeTag previous;
+    explicit AllocationScope(AllocationScopeTag tag) : previous(allocationScope) { allocationScope = tag; }
+    ~AllocationScope() { allocationScope = previous; }
+};
+
+// Totais por frame da thread principal. No modo de checagem, um frame depois do aquecimento que aloque
+// dentro de um escopo marcado conta como falha
+struct AllocationReport {
+    bool check = false;
+    long long warmupFrames = 300;
+    long long frames = 0;
+    long long framesWithAllocations = 0; // Frames (depois do aquecimento) com alocações em escopos marcados
+    long long worstFrame = -1;
+    long long worstFrameAllocations = 0;
+    long long peakHeapBytes = 0;
+    AllocationCounters total;
+    AllocationCounters interval;         // Desde o último printAllocationInterval()
+    long long intervalFrames = 0;
+    long long intervalPeakHeapBytes = 0;
+    AllocationCounters lastFrame;        // Último frame fechado, para o HUD de desempenho
+};
+
+AllocationReport allocationReport;
+
+const int ALLOCATION_CHECK_MAX_MESSAGES = 10;
+
+// "update 1.5 (24.0 B) | spawn ..." em 'out', para o log e para os relatórios
+void formatAllocationBreakdown(char* out, size_t size, const AllocationCounters& counters, double frames, int precision) {
+    int length = 0;
+    for (int tag = 0; tag < ALLOC_SCOPE_COUNT && (size_t)length < size; tag++) {
+        length += std::snprintf(out + length, size - length, "%s%s %.*f (%.*f B)", tag ? " | " : "", allocationScopeNames[tag],
+                                precision, counters.allocations[tag] / frames, precision, counters.bytes[tag] / frames);
+    }
+}
+
+void printAllocationBreakdown(const AllocationCounters& counters, double frames, int precision) {
+    char text[256];
+    formatAllocationBreakdown(text, sizeof(text), counters, frames, precision);
+    std::cout << text;
+}
+
+// Fecha o frame: acumula os contadores da thread principal e zera os do frame
+void endAllocationFrame() {
+    if (!allocationTracking.load(std::memory_order_relaxed)) return;
+    AllocationReport& report = allocationReport;
+    AllocationCounters frame = frameAllocations;
+    frameAllocations = AllocationCounters();
+    report.lastFrame = frame;
+    long long peak = framePeakHeapBytes.exchange(liveHeapBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    report.total.add(frame);
+    report.interval.add(frame);
+    report.intervalFrames++;
+    report.peakHeapBytes = std::max(report.peakHeapBytes, peak);
+    report.intervalPeakHeapBytes = std::max(report.intervalPeakHeapBytes, peak);
+    long long tagged = frame.taggedAllocations();
+    if (report.frames >= report.warmupFrames && tagged > 0) {
+        if (report.check && report.framesWithAllocations < ALLOCATION_CHECK_MAX_MESSAGES) {
+            char text[256];
+            formatAllocationBreakdown(text, sizeof(text), frame, 1.0, 0);
+            LOG_WARN("alocacoes", "frame=%lld alocou: %s", report.frames, text);
+        }
+        report.framesWithAllocations++;
+        if (tagged > report.worstFrameAllocations) {
+            report.worstFrameAllocations = tagged;
+            report.worstFrame = report.frames;
+        }
+    }
+    report.frames++;
+}
+
+// Médias por frame desde a última chamada (linha periódica do jogo com --track-allocs)
+void printAllocationInterval() {
+    AllocationReport& report = allocationReport;
+    if (!allocationTracking.load(std::memory_order_relaxed) || report.intervalFrames == 0) return;
+    char text[256];
+    formatAllocationBreakdown(text, sizeof(text), report.interval, (double)report.intervalFrames, 1);
+    LOG_INFO("alocacoes", "por frame: %s | pico_kb=%.1f", text, report.intervalPeakHeapBytes / 1024.0);
+    report.interval = AllocationCounters();
+    report.intervalFrames = 0;
+    report.intervalPeakHeapBytes = 0;
+}
+
+// Resumo final. Retorna false se a checagem encontrou frames estáveis que alocaram
+bool printAllocationReport() {
+    const AllocationReport& report = allocationReport;
+    if (!allocationTracking.load(std::memory_order_relaxed) || report.frames == 0) return true;
+    std::cout << std::fixed << "Alocações/frame: ";
+    printAllocationBreakdown(report.total, (double)report.frames, 2);
+    std::cout << std::endl << std::setprecision(1) << "Alocações: pico " << report.peakHeapBytes / (1024.0 * 1024.0)
+              << " MB vivos | " << report.framesWithAllocations << " de " << std::max(0LL, report.frames - report.warmupFrames)
+              << " frames depois do aquecimento (" << report.warmupFrames << ") alocaram";
+    if (report.worstFrame >= 0) std::cout << " | pior: frame " << report.worstFrame << " (" << report.worstFrameAllocations << ")";
+    std::cout << std::endl;
+    if (report.check && report.framesWithAllocations > 0) {
+        std::cout << "FALHA: frames em regime estável alocaram memória" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// ===================== Arena por frame =====================
+
+// Memória temporária de render e interface (textos formatados, vértices de tamanho variável):
+// alocação por incremento de ponteiro, liberada de uma vez em reset() no fim do frame. O que não
+// couber vem de blocos avulsos e a arena cresce até o pico no reset seguinte, então em regime
+// estável o frame não toca no heap
+const size_t FRAME_ARENA_BYTES = 64 * 1024;
+
+struct FrameArena {
+    std::unique_ptr<unsigned char[]> block;
+    size_t capacity = 0;
+    size_t used = 0;
+    size_t overflowBytes = 0;                                 // Bytes que não couberam neste frame
+    size_t peakBytes = 0;                                     // Maior uso de um frame
+    std::vector<std::unique_ptr<unsigned char[]>> overflow;
+
+    // 'alignment' deve ser potência de 2 e no máximo alignof(std::max_align_t)
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        size_t offset = (used + alignment - 1) & ~(alignment - 1);
+        if (offset + bytes <= capacity) {
+            used = offset + bytes;
+            return block.get() + offset;
+        }
+        overflowBytes += bytes;
+        overflow.emplace_back(new unsigned char[std::max<size_t>(bytes, 1)]);
+        return overflow.back().get();
+    }
+
+    template <typename T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "a arena não chama destrutores");
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Só no fim do frame: invalida tudo o que foi alocado nele
+    void reset() {
+        peakBytes = std::max(peakBytes, used + overflowBytes);
+        if (!overflow.empty() || !block) {
+            overflow.clear();
+            capacity = std::max(FRAME_ARENA_BYTES, peakBytes + peakBytes / 2);
+            block.reset(new unsigned char[capacity]);
+        }
+        used = 0;
+        overflowBytes = 0;
+    }
+};
+
+FrameArena frameArena;
+
+// printf na arena: o texto vale até o fim do frame
+std::string_view frameFormat(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    va_list measure;
+    va_copy(measure, args);
+    int length = vsnprintf(nullptr, 0, format, measure);
+    va_end(measure);
+    if (length < 0) {
+        va_end(args);
+        return std::string_view();
+    }
+    char* text = frameArena.allocate<char>((size_t)length + 1);
+    vsnprintf(text, (size_t)length + 1, format, args);
+    va_end(args);
+    return std::string_view(text, (size_t)length);
+}
+
+// Função para compilar shader
+unsigned int compileShader(unsigned int type, const char* source) {
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    
+    int success;
+    char infoLog[512];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        LOG_ERROR("shader", "erro de compilação: %s", infoLog);
+    }
+    
+    return shader;
+}
+
+// Função para criar programa de shader
+unsigned int createAndLinkShaderProgram(const char* vsSource, const char* fsSource) {
+    unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vsSource);
+    unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fsSource);
+    
+    unsigned int program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    
+    int success;
+    char infoLog[512];
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        LOG_ERROR("shader", "erro de linkagem: %s", infoLog);
+    }
+    
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return program;
+}
+
+// Adicione esta constante antes da função initTextRendering
+const std::string EXTENDED_CHARS = "áàâãéèêíìîóòôõúùûçÁÀÂÃÉÈÊÍÌÎÓÒÔÕÚÙÛÇ";
+
+// Modificar a função initTextRendering para criar o shader program e VAO/VBO
+void initTextRendering() {
+    PROFILE_ZONE("initTextRendering");
+    // Inicializar FreeType
+    if (FT_Init_FreeType(&ft)) {
+        LOG_ERROR("fonte", "não foi possível inicializar a biblioteca FreeType");
+        return;
+    }
+
+    // Tentar carregar a fonte do caminho específico primeiro
+    if (FT_New_Face(ft, FONT_PATH, 0, &face)) {
+        // Se falhar, tentar uma fonte do Windows como fallback
+        LOG_WARN("fonte", "não foi possível carregar %s, tentando fonte do sistema", FONT_PATH);
+        if (FT_New_Face(ft, "C:/Windows/Fonts/arial.ttf", 0, &face)) {
+            LOG_ERROR("fonte", "falha ao carregar qualquer fonte");
+            return;
+        }
+    }
+
+    // Definir tamanho da fonte
+    FT_Set_Pixel_Sizes(face, 0, FONT_PIXEL_HEIGHT_LOAD);
+    
+    // Ativar suporte a Unicode
+    FT_Select_Charmap(face, FT_ENCODING_UNICODE);
+
+    // Configurar OpenGL
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // Gerar texturas para os primeiros 128 caracteres ASCII
+    for (int c = 0; c < 128; c++) {
+        // Carregar caractere
+        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
+            LOG_ERROR("fonte", "falha ao carregar glifo %d", c);
+            continue;
+        }
+
+        // Gerar textura
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(
+            GL_TEXTURE_2D,
+            0,
+            GL_RED,
+            face->glyph->bitmap.width,
+            face->glyph->bitmap.rows,
+            0,
+            GL_RED,
+            GL_UNSIGNED_BYTE,
+            face->glyph->bitmap.buffer
+        );
+
+        // Definir opções de textura
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // Armazenar caractere para uso posterior
+        Character character = {
+            texture,
+            Point(face->glyph->bitmap.width, face->glyph->bitmap.rows),
+            Point(face->glyph->bitmap_left, face->glyph->bitmap_top),
+            (unsigned int)face->glyph->advance.x
+        };
+        Characters.insert(std::pair<int, Character>(c, character));
+    }
+
+    // Lista de caracteres especiais para pré-carregar
+    const wchar_t specialChars[] = L"áàâãéèêíìîóòôõúùûçÁÀÂÃÉÈÊÍÌÎÓÒÔÕÚÙÛÇ";
+    
+    // Adicionar caracteres especiais do português
+    for (int i = 0; specialChars[i] != L'\0'; i++) {
+        wchar_t c = specialChars[i];
+        
+        // Carregar caractere
+        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
+            LOG_ERROR("fonte", "falha ao carregar glifo especial %d", (int)c);
+            continue;
+        }
+
+        // Gerar textura
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(
+            GL_TEXTURE_2D,
+            0,
+            GL_RED,
+            face->glyph->bitmap.width,
+            face->glyph->bitmap.rows,
+            0,
+            GL_RED,
+            GL_UNSIGNED_BYTE,
+            face->glyph->bitmap.buffer
+        );
+
+        // Definir opções de textura
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // Armazenar caractere para uso posterior usando o valor Unicode como chave
+        Character character = {
+            texture,
+            Point(face->glyph->bitmap.width, face->glyph->bitmap.rows),
+            Point(face->glyph->bitmap_left, face->glyph->bitmap_top),
+            (unsigned int)face->glyph->advance.x
+        };
+        Characters.insert(std::pair<int, Character>((int)c, character));
+    }
+
+    // Criar o shader program para texto
+    textShaderProgram = createAndLinkShaderProgram(textVertexShaderSource, textFragmentShaderSource);
+    
+    // Configurar o VAO e VBO para o texto
+    glGenVertexArrays(1, &textVAO);
+    glGenBuffers(1, &textVBO);
+    glBindVertexArray(textVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+// Função auxiliar para obter o próximo ponto de código UTF-8
+int utf8_next(std::string_view str, size_t& pos) {
+    if (pos >= str.length()) return 0;
+    
+    unsigned char c = str[pos++];
+    
+    // ASCII comum (0-127)
+    if (c < 128) return c;
+    
+    // Obter o número de bytes adicionais
+    int extra = 0;
+    if ((c & 0xE0) == 0xC0) extra = 1;      // 110xxxxx
+    else if ((c & 0xF0) == 0xE0) extra = 2; // 1110xxxx
+    else if ((c & 0xF8) == 0xF0) extra = 3; // 11110xxx
+    else return '?';  // Formato inválido
+    
+    // Calcular o ponto de código
+    int codepoint = (c & (0x3F >> extra));
+    
+    // Ler bytes adicionais
+    for (int i = 0; i < extra && pos < str.length(); i++) {
+        c = str[pos++];
+        if ((c & 0xC0) != 0x80) return '?'; // Formato inválido
+        codepoint = (codepoint << 6) | (c & 0x3F);
+    }
+    
+    return codepoint;
+}
+
+// Percorre os glifos de 'text' e entrega o quad (x, y, u, v) de cada um; a parte de CPU de
+// RenderText, separada do GL para poder ser medida (--bench)
+template <typename Fn>
+void forEachGlyph(std::string_view text, float x, float y_baseline, float scale, Fn&& fn) {
+    // Percorrer a string usando a função auxiliar para caracteres UTF-8
+    size_t pos = 0;
+    while (pos < text.length()) {
+        int codepoint = utf8_next(text, pos);
+        if (codepoint == 0) break;
+
+        // Verificar se temos este caractere carregado
+        auto found = Characters.find(codepoint);
+        if (found == Characters.end()) {
+            x += (Characters['?'].Advance >> 6) * scale; // Corrigido: primeiro faz o shift, depois multiplica
+            continue;
+        }
+
+        const Character& ch = found->second;
+
+        float xpos = x + ch.Bearing.x * scale;
+        float ypos = y_baseline - (ch.Size.y - ch.Bearing.y) * scale;
+
+        float w = ch.Size.x * scale;
+        float h = ch.Size.y * scale;
+        
+        // Atualizar VBO para cada caractere
+        float vertices[6][4] = {
+            { xpos,     ypos + h,   0.0f, 0.0f },            
+            { xpos,     ypos,       0.0f, 1.0f },
+            { xpos + w, ypos,       1.0f, 1.0f },
+
+            { xpos,     ypos + h,   0.0f, 0.0f },
+            { xpos + w, ypos,       1.0f, 1.0f },
+            { xpos + w, ypos + h,   1.0f, 0.0f }           
+        };
+        fn(ch, vertices);
+        
+        // Avançar para o próximo glifo
+        x += (ch.Advance >> 6) * scale; // Corrigido: primeiro faz o shift, depois multiplica
+    }
+}
+
+// Substituir a função RenderText com a implementação correta para Unicode
+void RenderText(std::string_view text, float x, float y_baseline, float scale, Color color) {
+    PROFILE_ZONE("RenderText");
+    // Ativar o shader correspondente
+    glUseProgram(textShaderProgram);
+    setProjectionMatrix(textShaderProgram);
+    
+    glUniform3f(glGetUniformLocation(textShaderProgram, "textColor"), color.r, color.g, color.b);
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(glGetUniformLocation(textShaderProgram, "textSampler"), 0);
+    glBindVertexArray(textVAO);
+
+    forEachGlyph(text, x, y_baseline, scale, [](const Character& ch, const float (&vertices)[6][4]) {
+        // Renderizar a textura do glifo sobre o quad
+        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
+        
+        // Atualizar conteúdo do VBO
+        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); 
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        
+        // Renderizar quad
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+    });
+    
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Funções de renderização OpenGL modernas
+void setProjectionMatrix(unsigned int currentShaderProgram) { // Aceita o shader program
+    glUseProgram(currentShaderProgram);
+    
+    // Matriz de projeção ortográfica
+    float left = 0.0f, right = (float)WINDOW_WIDTH;
+    float bottom = 0.0f, top = (float)WINDOW_HEIGHT;
+    float near = -1.0f, far = 1.0f;
+    
+    float projection[16] = {
+        2.0f / (right - left), 0.0f, 0.0f, 0.0f,
+        0.0f, 2.0f / (top - bottom), 0.0f, 0.0f,
+        0.0f, 0.0f, -2.0f / (far - near), 0.0f,
+        -(right + left) / (right - left), -(top + bottom) / (top - bottom), -(far + near) / (far - near), 1.0f
+    };
+    
+    int projLoc = glGetUniformLocation(currentShaderProgram, "projection");
+    glUniformMatrix4fv(projLoc, 1, GL_FALSE, projection);
+}
+
+void drawCircle(float x, float y, float radius, Color color) {
+    const int segments = 32;
+    float vertices[(segments + 2) * 2];
+    
+    // Centro
+    vertices[0] = x;
+    vertices[1] = y;
+    
+    // Pontos do círculo
+    for (int i = 0; i <= segments; i++) {
+        float angle = 2.0f * (float)M_PI * i / segments;
+        vertices[2 + i * 2] = x + cos(angle) * radius;
+        vertices[3 + i * 2] = y + sin(angle) * radius;
+    }
+    
+    glUseProgram(shaderProgram); // Usar shader de formas
+    setProjectionMatrix(shaderProgram); // Passar o shader program
+    
+    int colorLoc = glGetUniformLocation(shaderProgram, "color");
+    glUniform4f(colorLoc, color.r, color.g, color.b, color.a);
+    
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
+    
+    glDrawArrays(GL_TRIANGLE_FAN, 0, segments + 2);
+    
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+// Nova função para desenhar hexágono
+void drawHexagon(float x, float y, float radius, Color color) {
+    const int segments = 6; // Um hexágono tem 6 lados
+    float vertices[(segments + 2) * 2];
+
+    // Centro (para TRIANGLE_FAN)
+    vertices[0] = x;
+    vertices[1] = y;
+
+    // Pontos do hexágono
+    for (int i = 0; i <= segments; i++) { // <= para fechar o hexágono
+        // ROTAÇÃO: Adiciona π/6 radianos (30°) para alinhar a base
+        float angle = 2.0f * (float)M_PI * i / segments + (M_PI / 6.0f); // Adiciona rotação para alinhar a base
+        vertices[2 + i * 2] = x + cos(angle) * radius;
+        vertices[3 + i * 2] = y + sin(angle) * radius;
+    }
+
+    glUseProgram(shaderProgram);
+    setProjectionMatrix(shaderProgram);
+
+    int colorLoc = glGetUniformLocation(shaderProgram, "color");
+    glUniform4f(colorLoc, color.r, color.g, color.b, color.a);
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
+
+    glDrawArrays(GL_TRIANGLE_FAN, 0, segments + 2);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void drawRectangle(float x, float y, float width, float height, Color color) {
+    float vertices[] = {
+        x, y,
+        x + width, y,
+        x + width, y + height,
+        x, y + height
+    };
+    
+    glUseProgram(shaderProgram); // Usar shader de formas
+    setProjectionMatrix(shaderProgram); // Passar o shader program
+    
+    int colorLoc = glGetUniformLocation(shaderProgram, "color");
+    glUniform4f(colorLoc, color.r, color.g, color.b, color.a);
+    
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
+    
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void drawLine(Point start, Point end, Color color, float width = 1.0f) {
+    float vertices[] = {
+        start.x, start.y,
+        end.x, end.y
+    };
+    
+    glUseProgram(shaderProgram); // Usar shader de formas
+    setProjectionMatrix(shaderProgram); // Passar o shader program
+    
+    int colorLoc = glGetUniformLocation(shaderProgram, "color");
+    glUniform4f(colorLoc, color.r, color.g, color.b, color.a);
+    
+    glLineWidth(width);
+    
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
+    
+    glDrawArrays(GL_LINES, 0, 2);
+    
+    glLineWidth(1.0f);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+// Polilinha inteira num draw call; 'vertices' tem 'points' pares (x, y), em geral na arena do frame
+void drawLineStrip(const float* vertices, int points, Color color) {
+    if (points < 2) return;
+    glUseProgram(shaderProgram);
+    setProjectionMatrix(shaderProgram);
+
+    int colorLoc = glGetUniformLocation(shaderProgram, "color");
+    glUniform4f(colorLoc, color.r, color.g, color.b, color.a);
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, points * 2 * sizeof(float), vertices, GL_DYNAMIC_DRAW);
+
+    glDrawArrays(GL_LINE_STRIP, 0, points);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+// ===================== HUD de desempenho =====================
+
+// Overlay ligado pela tecla F3 (ou --hud): gráficos do tempo de frame e de tick dos últimos
+// PERF_HUD_SAMPLES frames com p50/p95/p99, draw calls e trocas de estado do frame anterior, tamanho
+// de cada pool de entidades e alocações por frame. Tudo sai da arena do frame, sem alocar
+const int PERF_HUD_SAMPLES = 240;
+const float PERF_HUD_GRAPH_MAX_MS = 33.3f;  // Topo dos gráficos; a linha de referência fica em 16,7 ms
+
+struct PerfHud {
+    bool visible = false;
+    bool trackingByHud = false;             // O HUD ligou o rastreamento de alocações e o desliga ao sumir
+    float frameMs[PERF_HUD_SAMPLES] = {};
+    float tickMs[PERF_HUD_SAMPLES] = {};
+    int next = 0;                           // Próxima posição dos anéis
+    int count = 0;
+
+    void add(float frame, float tick) {
+        frameMs[next] = frame;
+        tickMs[next] = tick;
+        next = (next + 1) % PERF_HUD_SAMPLES;
+        count = std::min(count + 1, PERF_HUD_SAMPLES);
+    }
+};
+
+PerfHud perfHud;
+
+void togglePerfHud() {
+    perfHud.visible = !perfHud.visible;
+    if (perfHud.visible && !allocationTracking.load()) {
+        allocationTracking = true;
+        perfHud.trackingByHud = true;
+    } else if (!perfHud.visible && perfHud.trackingByHud) {
+        allocationTracking = false;
+        perfHud.trackingByHud = false;
+    }
+}
+
+struct PerfHudPercentiles {
+    float p50, p95, p99;
+};
+
+// Mesmo critério de índice de TimingSamples::percentile, sobre uma cópia na arena
+PerfHudPercentiles perfHudPercentiles(const float* ring, int count) {
+    if (count == 0) return {0.0f, 0.0f, 0.0f};
+    float* sorted = frameArena.allocate<float>(count);
+    std::copy(ring, ring + count, sorted);
+    auto at = [&](float p) {
+        int index = std::min(count - 1, (int)(p * (count - 1) + 0.5f));
+        std::nth_element(sorted, sorted + index, sorted + count);
+        return sorted[index];
+    };
+    return {at(0.50f), at(0.95f), at(0.99f)};
+}
+
+// Gráfico de um anel, da amostra mais antiga (esquerda) à mais nova, num único GL_LINE_STRIP
+void drawPerfHudGraph(const float* ring, float x, float y, float width, float height, Color color) {
+    drawRectangle(x, y, width, height, Color(0.0f, 0.0f, 0.0f, 0.35f));
+    float reference = y + height * (16.7f / PERF_HUD_GRAPH_MAX_MS);
+    drawLine(Point(x, reference), Point(x + width, reference), Color(1.0f, 1.0f, 1.0f, 0.25f));
+
+    int count = perfHud.count;
+    if (count < 2) return;
+    int first = (perfHud.next - count + PERF_HUD_SAMPLES) % PERF_HUD_SAMPLES;
+    float step = width / (PERF_HUD_SAMPLES - 1);
+    float* vertices = frameArena.allocate<float>(count * 2);
+    for (int i = 0; i < count; i++) {
+        float ms = std::min(ring[(first + i) % PERF_HUD_SAMPLES], PERF_HUD_GRAPH_MAX_MS);
+        vertices[i * 2] = x + width - (count - 1 - i) * step;
+        vertices[i * 2 + 1] = y + height * (ms / PERF_HUD_GRAPH_MAX_MS);
+    }
+    drawLineStrip(vertices, count, color);
+}
+
+void drawPerfHud() {
+    PROFILE_ZONE("drawPerfHud");
+    const float width = 470.0f;
+    const float margin = 20.0f;
+    const float lineHeight = 18.0f;
+    const float graphHeight = 50.0f;
+    const float scale = 0.42f;
+    const float padding = 8.0f;
+    const Color frameColor(1.0f, 0.85f, 0.3f);
+    const Color tickColor(0.4f, 0.85f, 1.0f);
+    const float height = padding * 3 + lineHeight * 7 + graphHeight * 2;
+    const float x = WINDOW_WIDTH - width - margin;
+    float y = WINDOW_HEIGHT - margin - height;
+    drawRectangle(x, y, width, height, COLOR_FEEDBACK_BG);
+
+    float textX = x + padding;
+    float currentY = y + height - padding - lineHeight * 0.8f;
+    PerfHudPercentiles frame = perfHudPercentiles(perfHud.frameMs, perfHud.count);
+    PerfHudPercentiles tick = perfHudPercentiles(perfHud.tickMs, perfHud.count);
+    int last = (perfHud.next - 1 + PERF_HUD_SAMPLES) % PERF_HUD_SAMPLES;
+    RenderText(frameFormat("Frame %.2f ms | p50 %.2f | p95 %.2f | p99 %.2f", perfHud.frameMs[last],
+                           frame.p50, frame.p95, frame.p99), textX, currentY, scale, frameColor);
+    currentY -= lineHeight;
+    RenderText(frameFormat("Tick %.3f ms | p50 %.3f | p95 %.3f | p99 %.3f", perfHud.tickMs[last],
+                           tick.p50, tick.p95, tick.p99), textX, currentY, scale, tickColor);
+    currentY -= lineHeight;
+
+    float graphWidth = width - padding * 2;
+    float graphY = currentY - graphHeight;
+    drawPerfHudGraph(perfHud.frameMs, textX, graphY, graphWidth, graphHeight, frameColor);
+    graphY -= graphHeight + padding;
+    drawPerfHudGraph(perfHud.tickMs, textX, graphY, graphWidth, graphHeight, tickColor);
+    currentY = graphY - lineHeight;
+
+    RenderText(frameFormat("Draw calls %lld | trocas de estado %lld", renderStats.lastDrawCalls, renderStats.lastStateChanges),
+               textX, currentY, scale, COLOR_TEXT_UI);
+    currentY -= lineHeight;
+    size_t dormant = 0;
+    int activeTables = 0;
+    for (const auto& table : enemyTables) {
+        if (table.has<Dormant>()) dormant += table.enemies.size();
+        activeTables += !table.enemies.empty();
+    }
+    RenderText(frameFormat("Inimigos %zu (%zu dormentes, %d tabelas) | torres %zu", enemyCount(), dormant,
+                           activeTables, towers.size()), textX, currentY, scale, COLOR_TEXT_UI);
+    currentY -= lineHeight;
+    RenderText(frameFormat("Projéteis %zu teleguiados + %zu balísticos | eventos %zu", projectiles.size(),
+                           ballisticProjectilesInFlight(), simTimers.pending), textX, currentY, scale, COLOR_TEXT_UI);
+    currentY -= lineHeight;
+
+    // Alocações do frame anterior (o HUD liga o rastreamento enquanto está visível)
+    const AllocationCounters& allocations = allocationReport.lastFrame;
+    long long allocationCount = 0;
+    long long allocationBytes = 0;
+    for (int tag = 0; tag < ALLOC_SCOPE_COUNT; tag++) {
+        allocationCount += allocations.allocations[tag];
+        allocationBytes += allocations.bytes[tag];
+    }
+    RenderText(frameFormat("Alocações/frame %lld (%lld B) | heap %.1f KB", allocationCount, allocationBytes,
+                           std::max(0LL, liveHeapBytes.load(std::memory_order_relaxed)) / 1024.0), textX, currentY, scale, COLOR_TEXT_UI);
+    currentY -= lineHeight;
+    RenderText(frameFormat("update %lld | spawn %lld | render %lld | interface %lld | outros %lld",
+                           allocations.allocations[ALLOC_SCOPE_UPDATE], allocations.allocations[ALLOC_SCOPE_SPAWN],
+                           allocations.allocations[ALLOC_SCOPE_RENDER], allocations.allocations[ALLOC_SCOPE_UI],
+                           allocations.allocations[ALLOC_SCOPE_OTHER]), textX, currentY, scale, COLOR_TEXT_UI);
+}
+
+// Funções do jogo
+void initGame() {
+    money = simConfig.startMoney;
+    lives = simConfig.startLives;
+    currentWave = 0;
+    clearEnemyTables();
+    towers.clear();
+    projectiles.clear();
+    ballisticProjectiles.clear();
+    placingTowerType = NO_TOWER_TYPE;
+    waveInProgress = false;
+    gameOver = false;
+    frameCount = 0;
+    lastEnemySpawnTime = 0;
+    enemiesLeftToSpawn = 0;
+    nextEnemyId = 1;
+    currentFeedback.reserve(128); // showFeedback() copia para cá sem alocar
+    rebuildMapGrids();
+    rebuildSimTimers();
+}
+
+// Tick do próximo lote: spawnDelay depois do último, com a variação sorteada pela semente. O sorteio é
+// função do estado (último spawn e inimigos restantes), então rebuildSimTimers chega ao mesmo tick
+long long nextSpawnTick() {
+    long long delay = simConfig.spawnDelay;
+    if (simConfig.spawnJitter > 0.0f) {
+        RandomKey key = {simulationSeed, (unsigned int)lastEnemySpawnTime};
+        float offset = key.unit(RANDOM_STREAM_SPAWN_JITTER, (unsigned int)enemiesLeftToSpawn) * 2.0f - 1.0f;
+        delay = std::max(1LL, delay + std::llround(offset * simConfig.spawnJitter * simConfig.spawnDelay));
+    }
+    return lastEnemySpawnTime + delay;
+}
+
+// Agenda o próximo lote de inimigos, se a onda ainda tiver inimigos a gerar.
+// 'earliest' impede que um lote gerado dentro de update() agende outro para o mesmo tick
+void scheduleNextSpawn(long long earliest) {
+    if (waveInProgress && enemiesLeftToSpawn > 0) {
+        simTimers.schedule(std::max(earliest, nextSpawnTick()), TIMER_SPAWN, 0);
+    }
+}
+
+int waveEnemyCount(int wave) {
+    return simConfig.enemiesPerWaveBase + (wave * simConfig.enemiesPerWaveGrowth);
+}
+
+// Tipo do inimigo de índice 'spawnIndex' na onda. Por padrão todos são normais; com ondas mistas
+// (--enemy-kind mixed) o último das ondas múltiplas de bossEvery é o chefe e os demais seguem os pesos
+// dos tipos já liberados, numa sequência fixa (sem sortear, para não mexer no RNG)
+unsigned char enemyKindFor(int wave, int spawnIndex) {
+    if (simConfig.enemyKind != NO_ENEMY_KIND) return (unsigned char)simConfig.enemyKind;
+
+    bool lastOfWave = spawnIndex == waveEnemyCount(wave) - 1;
+    int totalWeight = 0;
+    for (int kind = 0; kind < ENEMY_KIND_COUNT; kind++) {
+        const EnemyKindTraits& traits = enemyKinds[kind];
+        if (lastOfWave && traits.bossEvery > 0 && wave % traits.bossEvery == 0) return (unsigned char)kind;
+        if (wave >= traits.firstWave) totalWeight += traits.spawnWeight;
+    }
+    if (totalWeight == 0) return ENEMY_NORMAL;
+
+    int slot = spawnIndex % totalWeight;
+    for (int kind = 0; kind < ENEMY_KIND_COUNT; kind++) {
+        const EnemyKindTraits& traits = enemyKinds[kind];
+        if (wave < traits.firstWave) continue;
+        if (slot < traits.spawnWeight) return (unsigned char)kind;
+        slot -= traits.spawnWeight;
+    }
+    return ENEMY_NORMAL;
+}
+
+void spawnEnemyBatch(long long earliestNext) {
+    PROFILE_ZONE("spawnEnemyBatch");
+    AllocationScope allocationScope(ALLOC_SCOPE_SPAWN);
+    for (int i = 0; i < simConfig.spawnBatch && enemiesLeftToSpawn > 0; i++) {
+        int spawnIndex = waveEnemyCount(currentWave) - enemiesLeftToSpawn;
+        unsigned char kind = enemyKindFor(currentWave, spawnIndex);
+        pendingSpawns.push_back({Enemy(currentWave, kind), initialEnemyState(currentWave, kind)});
+        enemiesLeftToSpawn--;
+    }
+    lastEnemySpawnTime = frameCount;
+    scheduleNextSpawn(earliestNext);
+}
+
+void spawnWave() {
+    PROFILE_ZONE("spawnWave");
+    AllocationScope allocationScope(ALLOC_SCOPE_SPAWN);
+    enemiesLeftToSpawn = waveEnemyCount(currentWave);
+    // Agora, em vez de criar todos os inimigos de uma vez,
+    // vamos criar apenas o primeiro lote e agendar os demais
+    spawnEnemyBatch(frameCount);
+    flushEnemyCommands(); // Fora de update(): o primeiro lote entra já
+}
+
+void scheduleTowerReady(unsigned int index) {
+    simTimers.schedule(towers[index].readyTime(), TIMER_TOWER_READY, index);
+}
+
+// Refaz todos os eventos da simulação a partir do estado (início de partida, snapshot restaurado,
+// torres inseridas diretamente no vetor)
+void rebuildSimTimers() {
+    simTimers.reset(frameCount);
+    readyTowers.clear();
+    for (unsigned int i = 0; i < towers.size(); i++) {
+        scheduleTowerReady(i);
+    }
+    scheduleNextSpawn(frameCount);
+
+    freeBallisticSlots.clear();
+    for (unsigned int i = 0; i < ballisticProjectiles.size(); i++) {
+        if (ballisticProjectiles[i].shot.hasHit) {
+            freeBallisticSlots.push_back(i);
+        } else {
+            simTimers.schedule(ballisticProjectiles[i].impactTick, TIMER_PROJECTILE_IMPACT, i);
+        }
+    }
+    forEachLiveEnemy<Dormant>([](Enemy& enemy, Dormant& dormant) {
+        simTimers.schedule(dormant.wakeTick, TIMER_ENEMY_WAKE, enemy.id);
+    });
+}
+
+void startWave() {
+    PROFILE_ZONE("startWave");
+    if (gameOver || waveInProgress) return;
+    waveInProgress = true;
+    currentWave++;
+    spawnWave();
+}
+
+// Distância de um ponto até o segmento p1-p2
+float distanceToSegment(float x, float y, Point p1, Point p2) {
+    float dx = p2.x - p1.x;
+    float dy = p2.y - p1.y;
+    float lengthSq = dx * dx + dy * dy;
+    float t = lengthSq > 0.0f ? ((x - p1.x) * dx + (y - p1.y) * dy) / lengthSq : 0.0f;
+    t = std::max(0.0f, std::min(1.0f, t));
+    float px = p1.x + t * dx - x;
+    float py = p1.y + t * dy - y;
+    return sqrt(px * px + py * py);
+}
+
+// Menor distância de um ponto até o caminho dos inimigos
+float distanceToPath(float x, float y) {
+    float closest = INFINITY;
+    for (size_t i = 0; i + 1 < path.size(); i++) {
+        closest = std::min(closest, distanceToSegment(x, y, path[i], path[i + 1]));
+    }
+    return closest;
+}
+
+// ===================== Raster de ocupação para posicionamento =====================
+
+const float TOWER_PLACEMENT_MIN_DIST_PATH = 30.0f;
+const float TOWER_PLACEMENT_MIN_DIST_TOWER = 40.0f;
+
+// Motivos de bloqueio de uma célula (bits)
+const unsigned char PLACEMENT_BLOCKED_PATH = 1;
+const unsigned char PLACEMENT_BLOCKED_TOWER = 2;
+
+int placementCellSize = 4; // Tamanho da célula do raster em pixels (--placement-cell)
+
+// Bitmap com uma célula por placementCellSize pixels. Uma célula fica bloqueada quando uma torre
+// centrada nela estaria perto demais do caminho (distância real ponto-segmento) ou de outra torre.
+// Reconstruído quando o caminho muda e atualizado incrementalmente a cada torre colocada
+struct PlacementGrid {
+    int cellSize = 4;
+    int columns = 0;
+    int rows = 0;
+    std::vector<unsigned char> cells;
+    bool textureDirty = true; // A textura do overlay precisa ser reenviada
+
+    // Marca com 'flag' as células cujo centro está a menos de 'radius' do segmento p1-p2
+    void stampSegment(Point p1, Point p2, float radius, unsigned char flag) {
+        int minColumn = std::max(0, (int)((std::min(p1.x, p2.x) - radius) / cellSize));
+        int maxColumn = std::min(columns - 1, (int)((std::max(p1.x, p2.x) + radius) / cellSize));
+        int minRow = std::max(0, (int)((std::min(p1.y, p2.y) - radius) / cellSize));
+        int maxRow = std::min(rows - 1, (int)((std::max(p1.y, p2.y) + radius) / cellSize));
+
+        for (int row = minRow; row <= maxRow; row++) {
+            float cy = (row + 0.5f) * cellSize;
+            for (int column = minColumn; column <= maxColumn; column++) {
+                float cx = (column + 0.5f) * cellSize;
+                if (distanceToSegment(cx, cy, p1, p2) < radius) {
+                    cells[row * columns + column] |= flag;
+                }
+            }
+        }
+        textureDirty = true;
+    }
+
+    void stampTower(const Tower& tower) {
+        stampSegment(tower.position, tower.position, TOWER_PLACEMENT_MIN_DIST_TOWER, PLACEMENT_BLOCKED_TOWER);
+    }
+
+    void rebuild() {
+        cellSize = std::max(1, placementCellSize);
+        columns = (WINDOW_WIDTH + cellSize - 1) / cellSize;
+        rows = (WINDOW_HEIGHT + cellSize - 1) / cellSize;
+        cells.assign((size_t)columns * rows, 0);
+
+        // No modo labirinto não há caminho fixo: só o espaçamento entre torres e a saída importam
+        for (size_t i = 0; i + 1 < path.size() && !simConfig.mazeMode; i++) {
+            stampSegment(path[i], path[i + 1], TOWER_PLACEMENT_MIN_DIST_PATH, PLACEMENT_BLOCKED_PATH);
+        }
+        for (const auto& tower : towers) {
+            stampTower(tower);
+        }
+        textureDirty = true;
+    }
+
+    // Bits de bloqueio da célula que contém (x, y); fora do mapa conta como bloqueado
+    unsigned char at(float x, float y) const {
+        int column = (int)std::floor(x / cellSize);
+        int row = (int)std::floor(y / cellSize);
+        if (column < 0 || row < 0 || column >= columns || row >= rows) {
+            return PLACEMENT_BLOCKED_PATH | PLACEMENT_BLOCKED_TOWER;
+        }
+        return cells[row * columns + column];
+    }
+};
+
+thread_local PlacementGrid placementGrid;
+
+bool flowFieldAllowsTower(float x, float y); // Modo labirinto (definida junto do flow field)
+
+// Consulta O(1) ao raster; não mostra mensagem (usada também pelo preview a cada frame)
+bool isPlacementFree(float x, float y) {
+    return placementGrid.at(x, y) == 0;
+}
+
+bool canPlaceTower(float x, float y) {
+    unsigned char blocked = placementGrid.at(x, y);
+    if (blocked & PLACEMENT_BLOCKED_TOWER) {
+        showFeedback("Muito perto de outra torre!");
+        return false;
+    }
+    if (blocked & PLACEMENT_BLOCKED_PATH) {
+        showFeedback("Muito perto do caminho!");
+        return false;
+    }
+    if (simConfig.mazeMode && !flowFieldAllowsTower(x, y)) {
+        showFeedback("Essa torre bloquearia a saída!");
+        return false;
+    }
+    return true;
+}
+
+// ===================== Modo labirinto: flow field até a saída =====================
+
+const int FLOW_UNREACHABLE = std::numeric_limits<int>::max() / 2;
+
+// Campo de distâncias (em células, vizinhança 4) de cada célula até a coluna de saída (borda direita).
+// Os inimigos descem o gradiente do campo. Torres bloqueiam células; como só se acrescentam
+// bloqueios durante a partida, as distâncias só aumentam e o reparo é incremental: invalida só as
+// células que perderam todo vizinho de suporte (distância - 1) e refaz o Dijkstra nessa região
+struct FlowField {
+    int cellSize = 16;
+    int columns = 0;
+    int rows = 0;
+    std::vector<unsigned char> blocked;
+    std::vector<int> distance;
+
+    // Buffers reaproveitados entre reparos
+    std::vector<int> checkQueue;
+    std::vector<int> affected;
+    std::vector<std::pair<int, int>> undoDistance; // (célula, distância anterior)
+    std::vector<int> undoBlocked;
+    std::vector<int> towerCellScratch;           // Células da torre em teste ou sendo adicionada
+    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> frontier;
+
+    // Métricas do reparo incremental (ms)
+    double lastRepairMs = 0.0;
+    double maxRepairMs = 0.0;
+    double totalRepairMs = 0.0;
+    int repairs = 0;
+
+    int cellIndex(int column, int row) const { return row * columns + column; }
+
+    int cellAt(float x, float y) const {
+        int column = std::max(0, std::min(columns - 1, (int)(x / cellSize)));
+        int row = std::max(0, std::min(rows - 1, (int)(y / cellSize)));
+        return cellIndex(column, row);
+    }
+
+    Point cellCenter(int cell) const {
+        return Point((cell % columns + 0.5f) * cellSize, (cell / columns + 0.5f) * cellSize);
+    }
+
+    // Vizinhos ortogonais; retorna quantos foram escritos em out
+    int neighbors(int cell, int out[4]) const {
+        int column = cell % columns;
+        int row = cell / columns;
+        int count = 0;
+        if (column > 0) out[count++] = cell - 1;
+        if (column < columns - 1) out[count++] = cell + 1;
+        if (row > 0) out[count++] = cell - columns;
+        if (row < rows - 1) out[count++] = cell + columns;
+        return count;
+    }
+
+    // Células cobertas por uma torre em (x, y). O raio garante que torres no espaçamento mínimo
+    // de posicionamento formem uma parede contínua
+    void towerCells(float x, float y, std::vector<int>& out) const {
+        float radius = TOWER_PLACEMENT_MIN_DIST_TOWER * 0.5f + cellSize * 0.5f;
+        int minColumn = std::max(0, (int)((x - radius) / cellSize));
+        int maxColumn = std::min(columns - 1, (int)((x + radius) / cellSize));
+        int minRow = std::max(0, (int)((y - radius) / cellSize));
+        int maxRow = std::min(rows - 1, (int)((y + radius) / cellSize));
+        out.clear();
+        for (int row = minRow; row <= maxRow; row++) {
+            for (int column = minColumn; column <= maxColumn; column++) {
+                Point c((column + 0.5f) * cellSize, (row + 0.5f) * cellSize);
+                if ((c.x - x) * (c.x - x) + (c.y - y) * (c.y - y) <= radius * radius) {
+                    out.push_back(cellIndex(column, row));
+                }
+            }
+        }
+    }
+
+    // BFS completo a partir da coluna de saída
+    void rebuild() {
+        cellSize = std::max(1, simConfig.mazeCellSize);
+        columns = (WINDOW_WIDTH + cellSize - 1) / cellSize;
+        rows = (WINDOW_HEIGHT + cellSize - 1) / cellSize;
+        blocked.assign((size_t)columns * rows, 0);
+        distance.assign((size_t)columns * rows, FLOW_UNREACHABLE);
+
+        for (const auto& tower : towers) {
+            towerCells(tower.position.x, tower.position.y, towerCellScratch);
+            for (int cell : towerCellScratch) blocked[cell] = 1;
+        }
+
+        checkQueue.clear();
+        for (int row = 0; row < rows; row++) {
+            int cell = cellIndex(columns - 1, row);
+            if (!blocked[cell]) {
+                distance[cell] = 0;
+                checkQueue.push_back(cell);
+            }
+        }
+        for (size_t head = 0; head < checkQueue.size(); head++) {
+            int cell = checkQueue[head];
+            int adjacent[4];
+            int count = neighbors(cell, adjacent);
+            for (int i = 0; i < count; i++) {
+                int n = adjacent[i];
+                if (!blocked[n] && distance[n] == FLOW_UNREACHABLE) {
+                    distance[n] = distance[cell] + 1;
+                    checkQueue.push_back(n);
+                }
+            }
+        }
+    }
+
+    // Bloqueia as células e repara as distâncias afetadas, registrando tudo para um possível desfazer
+    void blockCells(const std::vector<int>& cells) {
+        auto start = std::chrono::steady_clock::now();
+        undoDistance.clear();
+        undoBlocked.clear();
+        checkQueue.clear();
+        affected.clear();
+
+        for (int cell : cells) {
+            if (blocked[cell]) continue;
+            blocked[cell] = 1;
+            undoBlocked.push_back(cell);
+            undoDistance.push_back({cell, distance[cell]});
+            distance[cell] = FLOW_UNREACHABLE;
+            int adjacent[4];
+            int count = neighbors(cell, adjacent);
+            checkQueue.insert(checkQueue.end(), adjacent, adjacent + count);
+        }
+
+        // 1. Invalida as células que ficaram sem suporte, propagando para quem dependia delas
+        for (size_t head = 0; head < checkQueue.size(); head++) {
+            int cell = checkQueue[head];
+            int d = distance[cell];
+            if (blocked[cell] || d == FLOW_UNREACHABLE || d == 0) continue;
+
+            int adjacent[4];
+            int count = neighbors(cell, adjacent);
+            bool supported = false;
+            for (int i = 0; i < count && !supported; i++) {
+                supported = distance[adjacent[i]] == d - 1;
+            }
+            if (supported) continue;
+
+            undoDistance.push_back({cell, d});
+            distance[cell] = FLOW_UNREACHABLE;
+            affected.push_back(cell);
+            for (int i = 0; i < count; i++) {
+                if (distance[adjacent[i]] == d + 1) checkQueue.push_back(adjacent[i]);
+            }
+        }
+
+        // 2. Dijkstra (pesos unitários) só dentro da região invalidada, semeado pela sua borda
+        for (int cell : affected) {
+            int adjacent[4];
+            int count = neighbors(cell, adjacent);
+            int best = FLOW_UNREACHABLE;
+            for (int i = 0; i < count; i++) {
+                best = std::min(best, distance[adjacent[i]] + 1);
+            }
+            if (best < FLOW_UNREACHABLE) frontier.push({best, cell});
+        }
+        while (!frontier.empty()) {
+            std::pair<int, int> top = frontier.top();
+            frontier.pop();
+            int d = top.first;
+            int cell = top.second;
+            if (d >= distance[cell]) continue;
+            distance[cell] = d;
+
+            int adjacent[4];
+            int count = neighbors(cell, adjacent);
+            for (int i = 0; i < count; i++) {
+                int n = adjacent[i];
+                if (!blocked[n] && d + 1 < distance[n]) frontier.push({d + 1, n});
+            }
+        }
+
+        lastRepairMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        maxRepairMs = std::max(maxRepairMs, lastRepairMs);
+        totalRepairMs += lastRepairMs;
+        repairs++;
+    }
+
+    // Desfaz o último blockCells
+    void undo() {
+        for (auto it = undoDistance.rbegin(); it != undoDistance.rend(); ++it) {
+            distance[it->first] = it->second;
+        }
+        for (int cell : undoBlocked) blocked[cell] = 0;
+        undoDistance.clear();
+        undoBlocked.clear();
+    }
+
+    // A entrada e todos os inimigos vivos que andam no chão ainda alcançam a saída?
+    bool exitReachable() const {
+        int entry = cellAt(path[0].x, path[0].y);
+        if (distance[entry] == FLOW_UNREACHABLE) return false;
+        bool reachable = true;
+        forEachLiveEnemy<>([&](const Enemy& enemy) {
+            if (!enemyKinds[enemy.kind].flying &&
+                distance[cellAt(enemy.position.x, enemy.position.y)] == FLOW_UNREACHABLE) {
+                reachable = false;
+            }
+        });
+        return reachable;
+    }
+
+    // Testa se uma torre em (x, y) mantém a saída alcançável (aplica, verifica e desfaz)
+    bool canBlock(float x, float y) {
+        towerCells(x, y, towerCellScratch);
+        blockCells(towerCellScratch);
+        bool reachable = exitReachable();
+        undo();
+        return reachable;
+    }
+
+    void addTower(const Tower& tower) {
+        towerCells(tower.position.x, tower.position.y, towerCellScratch);
+        blockCells(towerCellScratch);
+    }
+
+    // Move 'position' em direção à vizinha (8 direções, sem cortar quinas) mais próxima da saída.
+    // Retorna true quando o inimigo sai pela borda direita
+    bool step(Point& position, float speed) const {
+        int cell = cellAt(position.x, position.y);
+        Point target;
+        if (distance[cell] == 0) {
+            target = Point((float)WINDOW_WIDTH, position.y); // Na coluna de saída: segue reto
+        } else {
+            int column = cell % columns;
+            int row = cell / columns;
+            int best = -1;
+            int bestDistance = distance[cell];
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    int nc = column + dx;
+                    int nr = row + dy;
+                    if ((dx == 0 && dy == 0) || nc < 0 || nr < 0 || nc >= columns || nr >= rows) continue;
+                    int n = cellIndex(nc, nr);
+                    if (blocked[n]) continue;
+                    if (dx != 0 && dy != 0 && (blocked[cellIndex(column + dx, row)] || blocked[cellIndex(column, row + dy)])) continue;
+                    if (distance[n] < bestDistance) {
+                        bestDistance = distance[n];
+                        best = n;
+                    }
+                }
+            }
+            if (best < 0) return false; // Sem saída (não deveria acontecer: bloqueios que isolam são rejeitados)
+            target = cellCenter(best);
+        }
+
+        float dx = target.x - position.x;
+        float dy = target.y - position.y;
+        float dist = sqrt(dx * dx + dy * dy);
+        if (dist < speed) {
+            position = target;
+        } else {
+            position.x += (dx / dist) * speed;
+            position.y += (dy / dist) * speed;
+        }
+        return position.x >= WINDOW_WIDTH - 0.5f;
+    }
+
+    double averageRepairMs() const { return repairs > 0 ? totalRepairMs / repairs : 0.0; }
+};
+
+thread_local FlowField flowField;
+
+bool flowFieldAllowsTower(float x, float y) {
+    return flowField.canBlock(x, y);
+}
+
+bool stepAlongFlowField(Point& position, float speed) {
+    return flowField.step(position, speed);
+}
+
+// Recalcula tudo que deriva do mapa e das torres (raster de posicionamento, cobertura do caminho e, no
+// modo labirinto, o flow field)
+void rebuildMapGrids() {
+    placementGrid.rebuild();
+    rebuildPathCoverage();
+    if (simConfig.mazeMode) {
+        flowField.rebuild();
+    }
+}
+
+// Adiciona a torre e atualiza o raster de ocupação (e o flow field no modo labirinto)
+void addTower(float x, float y, int type) {
+    towers.emplace_back(x, y, type);
+    scheduleTowerReady((unsigned int)towers.size() - 1);
+    placementGrid.stampTower(towers.back());
+    rebuildPathCoverage();
+    if (simConfig.mazeMode) {
+        flowField.addTower(towers.back());
+    }
+}
+
+void placeTower(float x, float y) {
+    if (placingTowerType == NO_TOWER_TYPE || gameOver) return;
+    
+    float cost = towerTypes[placingTowerType].cost;
+    if (money >= cost && canPlaceTower(x, y)) {
+        addTower(x, y, placingTowerType);
+        money -= cost;
+        placingTowerType = NO_TOWER_TYPE;
+        showFeedback("Torre colocada com sucesso!");
+    }
+}
+
+void selectTowerType(int type) {
+    if (gameOver) return;
+    
+    if (money >= towerTypes[type].cost) {
+        placingTowerType = type;
+        showFeedback(std::string("Torre ") + towerTypes[type].name + " selecionada. Clique para colocar.");
+    } else {
+        showFeedback(std::string("Dinheiro insuficiente para Torre ") + towerTypes[type].name + ".");
+    }
+}
+
+thread_local std::vector<EnemyProgress> progressScratch;
+
+// Radix LSD em 3 passadas de 11 bits sobre o float convertido em inteiro com a mesma ordem. O(n),
+// independente de quão fora de ordem a lista esteja
+void radixSortByProgress(std::vector<EnemyProgress>& items) {
+    auto key = [](float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits ^ ((bits >> 31) ? 0xFFFFFFFFu : 0x80000000u);
+    };
+    progressScratch.resize(items.size());
+    std::vector<EnemyProgress>* from = &items;
+    std::vector<EnemyProgress>* to = &progressScratch;
+    for (int shift = 0; shift < 32; shift += 11) {
+        unsigned int offsets[2048] = {};
+        for (const auto& item : *from) offsets[(key(item.progress) >> shift) & 2047]++;
+        unsigned int sum = 0;
+        for (auto& offset : offsets) {
+            unsigned int count = offset;
+            offset = sum;
+            sum += count;
+        }
+        for (const auto& item : *from) (*to)[offsets[(key(item.progress) >> shift) & 2047]++] = item;
+        std::swap(from, to);
+    }
+    if (from != &items) items.swap(progressScratch);
+}
+
+// Refaz enemiesByProgress. Em cada tabela os inimigos estão em ordem de chegada e os mais antigos
+// costumam estar mais à frente, então percorrer de trás para frente gera uma lista quase ordenada
+// (ordenação por inserção barata). Inimigos que acordaram do nível de detalhe entram no fim da tabela
+// e quebram essa ordem; se a inserção passar do orçamento, a lista vai para o radix
+void buildProgressIndex() {
+    PROFILE_ZONE("buildProgressIndex");
+    enemiesByProgress.clear();
+    forEachOccupiedTable([](EnemyTable& table) {
+        if (table.has<Dormant>()) return; // Fora da cobertura de todas as torres
+        const float* health = table.state.health.data();
+        const float* progress = table.state.progress.data();
+        for (size_t i = table.enemies.size(); i-- > 0;) {
+            if (health[i] > 0) {
+                enemiesByProgress.push_back({progress[i], &table.enemies[i]});
+            }
+        }
+    });
+    size_t shiftBudget = enemiesByProgress.size() * 8; // Se a lista estiver muito fora de ordem, usa o radix
+    for (size_t i = 1; i < enemiesByProgress.size(); i++) {
+        EnemyProgress item = enemiesByProgress[i];
+        size_t j = i;
+        for (; j > 0 && item < enemiesByProgress[j - 1] && shiftBudget > 0; j--, shiftBudget--) {
+            enemiesByProgress[j] = enemiesByProgress[j - 1];
+        }
+        enemiesByProgress[j] = item;
+        if (shiftBudget == 0) {
+            radixSortByProgress(enemiesByProgress);
+            break;
+        }
+    }
+}
+
+// O índice custa uma passada e uma ordenação por tick, e cada torre que o usa economiza uma varredura
+// de todos os inimigos acordados: medido, ele só se paga a partir de ~8 torres prontas no mesmo tick
+// (o jogo normal tem poucas torres e poucos inimigos, e a varredura direta ganha)
+const size_t PROGRESS_INDEX_MIN_TOWERS = 8;
+const size_t PROGRESS_INDEX_MIN_PAIRS = 64; // Torres prontas x inimigos acordados
+
+bool useProgressIndex(size_t readyCount) {
+    if (simConfig.mazeMode || readyCount < PROGRESS_INDEX_MIN_TOWERS) return false;
+    size_t awake = 0;
+    forEachOccupiedTable([&](const EnemyTable& table) {
+        if (!table.has<Dormant>()) awake += table.enemies.size();
+    });
+    return awake * readyCount >= PROGRESS_INDEX_MIN_PAIRS;
+}
+
+// ===================== Nível de detalhe do caminho =====================
+
+// A maior parte dos inimigos passa a maior parte do tempo em trechos que nenhuma torre alcança, onde
+// não há nada a decidir por tick. Quem não tem componentes e está fora da cobertura dorme (vai para
+// uma tabela com Dormant, que nenhum sistema percorre) e um evento na roda o acorda pouco antes de
+// chegar ao próximo trecho coberto ou à saída. Como o kernel de movimento calcula o progresso pela âncora, o
+// estado ao acordar é o mesmo de quem andou tick a tick, e o custo por tick acompanha só os
+// inimigos ao alcance das torres
+const int PATH_LOD_MIN_SLEEP_TICKS = 8; // Cochilos mais curtos custam mais (duas trocas de tabela) do que economizam
+const int PATH_LOD_SCAN_STRIDE = 8;     // Cada inimigo ativo é avaliado a cada N ticks (dormir mais tarde só custa ticks ativos)
+
+thread_local std::vector<PathInterval> coverageUnion; // Trechos cobertos por alguma torre, ordenados e disjuntos
+thread_local std::vector<PathInterval> coverageScratch; // Trechos de todas as torres, antes da fusão
+thread_local std::vector<PathInterval> coverageMerged;  // União nova; troca de lugar com coverageUnion
+
+// Inimigos-tick ativos e dormentes, para o relatório de estresse
+struct PathLodStats {
+    long long activeEnemyTicks = 0;
+    long long dormantEnemyTicks = 0;
+    long long wakes = 0;
+};
+thread_local PathLodStats pathLodStats;
+
+bool pathLodActive() {
+    return simConfig.pathLod && !simConfig.mazeMode && !simConfig.crowdSeparation;
+}
+
+// Só é chamada fora de update() (torres e mapa mudam entre ticks): aplica as mudanças na hora, para
+// que um snapshot tirado em seguida não encontre linhas pendentes
+void wakeAllDormantEnemies() {
+    forEachLiveEnemy<Dormant>([](Enemy& enemy, Dormant&) {
+        wakeEnemy(enemy.id);
+    });
+    flushEnemyCommands();
+    compactEnemyTables();
+}
+
+// Refaz a união das coberturas das torres. Se ela mudar (ou o nível de detalhe estiver desligado), os
+// dormentes acordam: os eventos deles foram calculados com a cobertura antiga
+void rebuildPathCoverage() {
+    std::vector<PathInterval>& intervals = coverageScratch;
+    intervals.clear();
+    for (const auto& tower : towers) {
+        intervals.insert(intervals.end(), tower.coverage, tower.coverage + tower.coverageCount);
+    }
+    std::sort(intervals.begin(), intervals.end(),
+              [](const PathInterval& a, const PathInterval& b) { return a.start < b.start; });
+    std::vector<PathInterval>& merged = coverageMerged;
+    merged.clear();
+    for (const auto& interval : intervals) {
+        if (!merged.empty() && interval.start <= merged.back().end) {
+            merged.back().end = std::max(merged.back().end, interval.end);
+        } else {
+            merged.push_back(interval);
+        }
+    }
+    bool changed = merged.size() != coverageUnion.size() ||
+                   !std::equal(merged.begin(), merged.end(), coverageUnion.begin(),
+                               [](const PathInterval& a, const PathInterval& b) { return a.start == b.start && a.end == b.end; });
+    coverageUnion.swap(merged);
+    if (changed || !pathLodActive()) wakeAllDormantEnemies();
+}
+
+// Com as torres cobrindo o caminho inteiro ninguém dorme e a varredura é pulada
+bool pathFullyCovered() {
+    return coverageUnion.size() == 1 && coverageUnion[0].start <= 0.0f && coverageUnion[0].end >= pathLengths.back();
+}
+
+// Início do próximo trecho coberto à frente de 'progress' (o fim do caminho se não houver); -1 se já estiver coberto
+float nextCoveredProgress(float progress) {
+    auto it = std::lower_bound(coverageUnion.begin(), coverageUnion.end(), progress,
+                               [](const PathInterval& interval, float value) { return interval.end < value; });
+    if (it == coverageUnion.end()) return pathLengths.back();
+    return it->start <= progress ? -1.0f : it->start;
+}
+
+// Roda depois do movimento: inimigos sem componentes fora da cobertura dormem até o tick em que poderiam
+// alcançar o próximo trecho coberto, com um tick de folga (o encaixe nas quinas só atrasa). Quem acabou de
+// mudar de velocidade (lentidão que venceu) anda mais um tick para refazer a âncora
+void updatePathLod() {
+    PROFILE_ZONE("updatePathLod");
+    long long dormant = 0;
+    long long total = 0;
+    forEachOccupiedTable([&](const EnemyTable& table) {
+        if (table.has<Dormant>()) dormant += (long long)table.enemies.size();
+        total += (long long)table.enemies.size();
+    });
+    pathLodStats.dormantEnemyTicks += dormant;
+    pathLodStats.activeEnemyTicks += total - dormant;
+    if (!pathLodActive() || pathFullyCovered()) return;
+
+    for (int kind = 0; kind < ENEMY_KIND_COUNT; kind++) {
+        const EnemyTable& table = enemyTables[enemyTableIndex(kind, 0)];
+        const EnemyColumns& state = table.state;
+        for (size_t row = frameCount % PATH_LOD_SCAN_STRIDE; row < table.enemies.size(); row += PATH_LOD_SCAN_STRIDE) {
+            const Enemy& enemy = table.enemies[row];
+            const float speed = state.speed[row];
+            if (state.health[row] <= 0 || speed <= 0.0f || state.anchorSpeed[row] != speed) continue;
+            float next = nextCoveredProgress(state.progress[row]);
+            if (next < 0.0f) continue;
+            long long ticks = (long long)((next - state.progress[row]) / speed) - 1;
+            if (ticks < PATH_LOD_MIN_SLEEP_TICKS) continue;
+            int wakeTick = frameCount + (int)std::min(ticks, (long long)std::numeric_limits<int>::max() / 2);
+            deferAddComponent(enemy.id, Dormant{wakeTick});
+            simTimers.schedule(wakeTick, TIMER_ENEMY_WAKE, enemy.id);
+        }
+    }
+}
+
+// Evento de despertar; os que ficaram para trás (inimigo morto, já acordado ou dormindo até outro tick) são ignorados
+void resolveEnemyWake(unsigned int id) {
+    Enemy* enemy = findEnemy(id);
+    if (!enemy || enemyHealth(id) <= 0 || !isEnemyDormant(id)) return;
+    const EnemyLocation& location = enemyLocations[id];
+    if (enemyTables[location.table].column<Dormant>()[location.row].wakeTick != frameCount) return;
+    wakeEnemy(id);
+    pathLodStats.wakes++;
+}
+
+// Tabelas em que só há dormentes sem efeitos de estado (uma por tipo de inimigo)
+constexpr uint64_t idleEnemyTables() {
+    uint64_t bits = 0;
+    for (int kind = 0; kind < ENEMY_KIND_COUNT; kind++) bits |= 1ull << enemyTableIndex(kind, COMPONENT_DORMANT);
+    return bits;
+}
+
+// Sem janela (avaliador): pula os ticks em que update() só avançaria frameCount. Isso vale quando todos
+// os inimigos dormem (ou não há inimigos), nenhum projétil teleguiado voa e ninguém tem efeitos: até o
+// próximo evento da roda (lote, recarga, impacto ou despertar) nenhum sistema teria trabalho, e torres
+// prontas não acham alvo. É o que faz o nível de detalhe render no avaliador, onde a maior parte dos
+// ticks de uma partida é de inimigos andando entre as coberturas. Retorna os ticks pulados
+long long skipIdleTicks(long long limit) {
+    if (gameOver || !waveInProgress || !projectiles.empty() || (occupiedEnemyTables & ~idleEnemyTables()) != 0) return 0;
+    if (enemiesLeftToSpawn == 0 && occupiedEnemyTables == 0) return 0; // O próximo update() encerra a onda
+    long long target = simTimers.skipToNextEvent(limit);
+    long long skipped = target - frameCount;
+    if (skipped <= 0) return 0;
+    pathLodStats.dormantEnemyTicks += skipped * (long long)enemyCount();
+    frameCount = (int)target;
+    return skipped;
+}
+
+// ===================== Separação de multidão =====================
+
+// Sem separação, inimigos gerados juntos andam empilhados no mesmo ponto. Com ela, a cada tick os
+// vivos são copiados para arrays compactos, indexados numa hash espacial de células do tamanho do
+// espaçamento mínimo, e cada um consulta as 3x3 células vizinhas: a sobreposição empurra para o lado
+// (dentro do corredor do caminho) e quem está logo à frente faz frear, a menos que seja mais lento,
+// caso em que o empurrão lateral vira ultrapassagem. Cada inimigo só lê o estado copiado e escreve
+// a sua própria saída, então a consulta se divide entre threads com o mesmo resultado
+const float CROWD_MIN_SPEED = 0.2f;         // Fração mínima da velocidade ao frear atrás de outro inimigo
+const float CROWD_LATERAL_RATE = 0.5f;      // Fração da sobreposição corrigida por tick na lateral
+const float CROWD_RECENTER_RATE = 0.02f;    // Volta gradual ao centro quando não há vizinhos
+const float CROWD_OVERTAKE_RATIO = 0.95f;   // Só ultrapassa quem anda abaixo desta fração da sua velocidade
+const int CROWD_MAX_NEIGHBORS = 12;         // Vizinhos considerados por inimigo (limita aglomerações densas)
+const int CROWD_MAX_CANDIDATES = 32;        // Candidatos examinados por inimigo, mesmo fora do espaçamento
+const size_t CROWD_PARALLEL_MIN_AGENTS = 4096; // Abaixo disso as threads custam mais do que economizam
+
+// Campos dos agentes (inimigos vivos) usados na separação, em arrays separados
+struct CrowdAgents {
+    std::vector<float> x, y;
+    std::vector<float> dirX, dirY; // Direção do segmento atual do caminho
+    std::vector<float> lane;
+    std::vector<float> speed;
+    std::vector<unsigned int> id;
+
+    void clear() {
+        x.clear(); y.clear(); dirX.clear(); dirY.clear(); lane.clear(); speed.clear(); id.clear();
+    }
+    void resize(size_t count) {
+        x.resize(count); y.resize(count); dirX.resize(count); dirY.resize(count);
+        lane.resize(count); speed.resize(count); id.resize(count);
+    }
+    void reserve(size_t count) {
+        x.reserve(count); y.reserve(count); dirX.reserve(count); dirY.reserve(count);
+        lane.reserve(count); speed.reserve(count); id.reserve(count);
+    }
+    size_t size() const { return x.size(); }
+};
+
+// Hash espacial refeito a cada tick: counting sort dos agentes pelo balde da sua célula. O número
+// de baldes é a potência de 2 acima de 2x os agentes, então não depende do tamanho do mapa. Os agentes
+// são copiados na ordem dos baldes: quem está na mesma célula é resolvido em sequência e lê os mesmos
+// vizinhos, que já estão no cache
+struct CrowdHash {
+    float cellSize = 1.0f;
+    float inverseCellSize = 1.0f;
+    unsigned int mask = 0;
+    std::vector<unsigned int> start;    // Início de cada balde em 'sorted' (baldes + 1 entradas)
+    CrowdAgents sorted;                 // Agentes agrupados por balde
+    std::vector<unsigned int> source;   // Índice original de cada posição de 'sorted'
+    std::vector<unsigned int> bucketOf; // Balde de cada agente
+    std::vector<unsigned int> fill;     // Próxima posição livre de cada balde durante o build
+
+    static unsigned int hashCell(int column, int row) {
+        return ((unsigned int)column * 73856093u) ^ ((unsigned int)row * 19349663u);
+    }
+
+    int cellOf(float value) const { return (int)std::floor(value * inverseCellSize); }
+
+    void build(const CrowdAgents& agents, float size) {
+        const size_t count = agents.size();
+        cellSize = size;
+        inverseCellSize = 1.0f / size;
+        unsigned int buckets = 1;
+        while (buckets < count * 2) buckets <<= 1;
+        mask = buckets - 1;
+        start.assign(buckets + 1, 0);
+        bucketOf.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            bucketOf[i] = hashCell(cellOf(agents.x[i]), cellOf(agents.y[i])) & mask;
+            start[bucketOf[i] + 1]++;
+        }
+        for (unsigned int b = 0; b < buckets; b++) start[b + 1] += start[b];
+        fill.assign(start.begin(), start.end() - 1);
+        sorted.resize(count);
+        source.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            unsigned int k = fill[bucketOf[i]]++;
+            sorted.x[k] = agents.x[i];
+            sorted.y[k] = agents.y[i];
+            sorted.dirX[k] = agents.dirX[i];
+            sorted.dirY[k] = agents.dirY[i];
+            sorted.lane[k] = agents.lane[i];
+            sorted.speed[k] = agents.speed[i];
+            sorted.id[k] = agents.id[i];
+            source[k] = (unsigned int)i;
+        }
+    }
+
+    // Chama fn(k) para os agentes (posições em 'sorted') das 3x3 células em volta de (x, y), começando
+    // pela célula central, até fn retornar false. Células diferentes podem cair no mesmo balde, então
+    // baldes repetidos são pulados; quem chama filtra pela distância real
+    template <typename Fn>
+    void forEachNear(float px, float py, Fn&& fn) const {
+        static const int offsets[9][2] = {{0, 0}, {-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {1, -1}, {-1, 1}, {1, 1}};
+        int column = cellOf(px);
+        int row = cellOf(py);
+        unsigned int visited[9];
+        int visitedCount = 0;
+        for (const auto& offset : offsets) {
+            unsigned int bucket = hashCell(column + offset[0], row + offset[1]) & mask;
+            bool repeated = false;
+            for (int v = 0; v < visitedCount; v++) repeated |= visited[v] == bucket;
+            if (repeated) continue;
+            visited[visitedCount++] = bucket;
+            for (unsigned int k = start[bucket]; k < start[bucket + 1]; k++) {
+                if (!fn(k)) return;
+            }
+        }
+    }
+};
+
+thread_local CrowdAgents crowdAgents;
+thread_local std::vector<Enemy*> crowdEnemies; // Inimigo de cada agente de crowdAgents
+thread_local CrowdHash crowdHash;
+thread_local std::vector<float> crowdLanes;  // Saída, na ordem do hash
+thread_local std::vector<float> crowdBrakes;
+
+// Métricas da separação (ms), para o relatório de estresse
+struct CrowdStats {
+    double lastMs = 0.0;
+    double maxMs = 0.0;
+    double totalMs = 0.0;
+    int ticks = 0;
+    size_t peakAgents = 0;
+};
+thread_local CrowdStats crowdStats;
+
+// Resolve as posições [begin, end) do hash. Empates exatos (inimigos no mesmo ponto, como num lote
+// recém-gerado) são decididos pelo id: o mais antigo fica à frente e à esquerda
+void solveCrowdRange(const CrowdHash& hash, float spacing, size_t begin, size_t end, float* newLane, float* brake) {
+    PROFILE_ZONE("solveCrowdRange");
+    const CrowdAgents& agents = hash.sorted;
+    const float spacingSq = spacing * spacing;
+    const float inverseSpacing = 1.0f / spacing;
+    for (size_t i = begin; i < end; i++) {
+        const float x = agents.x[i];
+        const float y = agents.y[i];
+        const float dirX = agents.dirX[i];
+        const float dirY = agents.dirY[i];
+        const unsigned int id = agents.id[i];
+        const float overtakeBelow = agents.speed[i] * CROWD_OVERTAKE_RATIO;
+        float push = 0.0f;
+        float factor = 1.0f;
+        int neighbors = 0;
+        int candidates = 0;
+        hash.forEachNear(x, y, [&](unsigned int k) {
+            if (++candidates > CROWD_MAX_CANDIDATES || neighbors >= CROWD_MAX_NEIGHBORS) return false;
+            if (k == i) return true;
+            float dx = agents.x[k] - x;
+            float dy = agents.y[k] - y;
+            float distanceSq = dx * dx + dy * dy;
+            if (distanceSq >= spacingSq) return true;
+            neighbors++;
+
+            // Sem desvios no corpo: o lado do vizinho e a frenagem variam de um vizinho para o outro
+            bool older = agents.id[k] < id;
+            float along = dx * dirX + dy * dirY;
+            float side = dy * dirX - dx * dirY; // Positivo: o vizinho está à esquerda
+            float tieSide = older ? 1.0f : -1.0f;
+            side = side != 0.0f ? side : tieSide;
+            float overlap = spacing - std::sqrt(distanceSq);
+            push -= std::copysign(overlap, side);
+
+            bool ahead = along > 0.0f || (along == 0.0f && older);
+            bool blocked = ahead && std::fabs(side) < spacing * 0.5f && agents.speed[k] >= overtakeBelow;
+            float limit = std::max(CROWD_MIN_SPEED, along * inverseSpacing);
+            factor = std::min(factor, blocked ? limit : 1.0f);
+            return true;
+        });
+
+        float lane = agents.lane[i];
+        lane = neighbors > 0 ? lane + push * CROWD_LATERAL_RATE : lane * (1.0f - CROWD_RECENTER_RATE);
+        newLane[i] = std::max(-CROWD_LANE_HALF_WIDTH, std::min(CROWD_LANE_HALF_WIDTH, lane));
+        brake[i] = factor;
+    }
+}
+
+// Trabalhadores da separação, criados na primeira vez que o tick os usa e mantidos até a thread da
+// simulação terminar: cada tick só acorda as threads, sem criar nem alocar nada. O trabalhador t
+// resolve a fatia t de 'count' e a thread da simulação resolve a fatia 0
+struct CrowdWorkerPool {
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    unsigned long long generation = 0; // Tick de trabalho atual; os trabalhadores esperam ele mudar
+    int pending = 0;                   // Trabalhadores que ainda não terminaram a sua fatia
+    bool stopping = false;
+    const CrowdHash* hash = nullptr;
+    int activeThreads = 1;             // Fatias deste tick; trabalhadores a mais só confirmam
+    size_t count = 0;
+    size_t chunk = 0;
+    float* lanes = nullptr;
+    float* brakes = nullptr;
+
+    void start(int workers) {
+        if ((int)threads.size() >= workers) return;
+        stop();
+        stopping = false;
+        threads.reserve(workers);
+        for (int t = 1; t <= workers; t++) {
+            threads.emplace_back([this, t, seen = generation]() { run(t, seen); });
+        }
+    }
+
+    void run(int t, unsigned long long seen) {
+        profilerThread = (uint32_t)t;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&]() { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            if (t < activeThreads) {
+                size_t begin = std::min(count, chunk * t);
+                size_t end = std::min(count, begin + chunk);
+                solveCrowdRange(*hash, simConfig.crowdSpacing, begin, end, lanes, brakes);
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) done.notify_one();
+        }
+    }
+
+    // Resolve 'count' agentes em 'active' fatias (a thread que chama faz a primeira)
+    void solve(const CrowdHash& source, int active, float* laneOut, float* brakeOut) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            hash = &source;
+            count = source.sorted.size();
+            chunk = (count + active - 1) / active;
+            lanes = laneOut;
+            brakes = brakeOut;
+            activeThreads = active;
+            pending = (int)threads.size();
+            generation++;
+        }
+        wake.notify_all();
+        solveCrowdRange(source, simConfig.crowdSpacing, 0, std::min(count, chunk), laneOut, brakeOut);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&]() { return pending == 0; });
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& thread : threads) thread.join();
+        threads.clear();
+    }
+
+    ~CrowdWorkerPool() { stop(); }
+};
+
+thread_local CrowdWorkerPool crowdWorkers;
+
+// Roda antes do movimento; o resultado fica em lane e crowdBrake de cada inimigo
+void separateCrowd() {
+    PROFILE_ZONE("separateCrowd");
+    auto start = std::chrono::steady_clock::now();
+    CrowdAgents& agents = crowdAgents;
+    std::vector<Enemy*>& enemies = crowdEnemies;
+    agents.clear();
+    enemies.clear();
+    // Reserva pela capacidade das tabelas, que já cresce em potências de 2 até o pico de inimigos
+    size_t capacity = 0;
+    forEachOccupiedTable([&](const EnemyTable& table) { capacity += table.enemies.capacity(); });
+    if (capacity > enemies.capacity()) {
+        agents.reserve(capacity);
+        enemies.reserve(capacity);
+    }
+    forEachOccupiedTable([&](EnemyTable& table) {
+        const Slow* slows = table.has<Slow>() ? table.column<Slow>().data() : nullptr;
+        const float resistance = enemyKinds[table.kind].slowResistance;
+        const EnemyColumns& state = table.state;
+        for (size_t row = 0; row < table.enemies.size(); row++) {
+            Enemy& enemy = table.enemies[row];
+            if (state.health[row] <= 0) continue;
+            const float speed = state.speed[row];
+            Point direction = pathDirection(pathSegmentAt(state.progress[row]));
+            agents.x.push_back(enemy.position.x);
+            agents.y.push_back(enemy.position.y);
+            agents.dirX.push_back(direction.x);
+            agents.dirY.push_back(direction.y);
+            agents.lane.push_back(enemy.lane);
+            agents.speed.push_back(slows ? speed * slowFactorFor(slows[row].factor, resistance) : speed);
+            agents.id.push_back(enemy.id);
+            enemies.push_back(&enemy);
+        }
+    });
+    const size_t count = agents.size();
+    CrowdHash& hash = crowdHash;
+    hash.build(agents, simConfig.crowdSpacing);
+    crowdLanes.resize(count);
+    crowdBrakes.resize(count);
+
+    // Os trabalhadores recebem o hash desta thread: o estado da simulação é thread_local
+    int threads = count >= CROWD_PARALLEL_MIN_AGENTS ? std::max(1, simConfig.crowdThreads) : 1;
+    if (threads > 1) {
+        crowdWorkers.start(threads - 1);
+        crowdWorkers.solve(hash, threads, crowdLanes.data(), crowdBrakes.data());
+    } else {
+        solveCrowdRange(hash, simConfig.crowdSpacing, 0, count, crowdLanes.data(), crowdBrakes.data());
+    }
+
+    for (size_t k = 0; k < count; k++) {
+        Enemy* enemy = enemies[hash.source[k]];
+        enemy->lane = crowdLanes[k];
+        enemy->crowdBrake = crowdBrakes[k];
+    }
+
+    crowdStats.lastMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    crowdStats.maxMs = std::max(crowdStats.maxMs, crowdStats.lastMs);
+    crowdStats.totalMs += crowdStats.lastMs;
+    crowdStats.ticks++;
+    crowdStats.peakAgents = std::max(crowdStats.peakAgents, count);
+}
+
+// ===================== Kernels por tipo de inimigo =====================
+
+// Cada tabela guarda um único tipo de inimigo, então os sistemas despacham uma vez por tabela (lote
+// homogêneo) para kernels instanciados com as características do tipo como constantes de compilação.
+// Um tipo novo em enemyKinds ganha seus kernels sem mudanças nos laços
+using EnemyBatchKernel = void (*)(EnemyTable&);
+
+const float PATH_END = INFINITY; // Próxima quina de quem já passou da última
+
+// Seleção sem desvio entre dois floats, pelos bits. Com ?: o GCC leva a conta do lado não escolhido para
+// dentro de um desvio e, como ela pode gerar exceção de ponto flutuante (-ftrapping-math, o padrão), não
+// converte mais o desvio em seleção: o laço fica com fluxo de controle e não vetoriza
+inline float selectFloat(bool condition, float a, float b) {
+    uint32_t mask = 0u - (uint32_t)condition;
+    uint32_t bitsA, bitsB;
+    std::memcpy(&bitsA, &a, sizeof(bitsA));
+    std::memcpy(&bitsB, &b, sizeof(bitsB));
+    uint32_t bits = (bitsA & mask) | (bitsB & ~mask);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Colunas de rascunho dos kernels, do tamanho do maior lote (reaproveitadas entre tabelas e ticks)
+thread_local std::vector<float> kernelCorners; // Progresso da próxima quina de cada linha
+thread_local std::vector<float> kernelBrakes;  // Freio da multidão de cada linha
+thread_local std::vector<int> kernelFlags;     // Linha atravessou uma quina (movimento) ou morreu (queimadura)
+
+template <int Kind>
+struct EnemyKernels {
+    static constexpr const EnemyKindTraits& traits = enemyKinds[Kind];
+
+    // Passo aritmético do movimento ao longo do caminho, sobre as colunas de estado. Sem ifs: seleções
+    // mascaradas por "vivo e ainda no caminho". Os ponteiros são __restrict (sem isso o GCC precisaria de
+    // mais testes de sobreposição do que aceita) e as seleções de float passam por selectFloat(); assim
+    // o laço vetoriza em -O3 (confirmado com -fopt-info-vec). Devolve quantos chegaram à saída
+    template <bool Slowed, bool InLane>
+    static int stepAlongPath(size_t count, const float* __restrict corners, const float* __restrict brakes,
+                             const Slow* __restrict slows, const float* __restrict speeds,
+                             float* __restrict progress, float* __restrict anchorProgress,
+                             float* __restrict anchorSpeed, int* __restrict anchorTick,
+                             float* __restrict health, int* __restrict crossed, int frame) {
+        int exited = 0;
+        for (size_t row = 0; row < count; row++) {
+            float speed = speeds[row];
+            if constexpr (InLane) speed *= brakes[row];
+            if constexpr (Slowed) speed *= slowFactorFor(slows[row].factor, traits.slowResistance);
+            const float current = progress[row];
+            const float corner = corners[row];
+            const float oldSpeed = anchorSpeed[row];
+            const float oldHealth = health[row];
+            // & no lugar de &&: o curto-circuito vira desvio e impede a vetorização
+            const bool alive = oldHealth > 0;
+            const bool atEnd = corner == PATH_END;
+            const bool exits = alive & atEnd;
+            const bool moving = alive & !atEnd;
+            const bool crosses = corner - current < speed; // Encaixa na quina quando falta menos que um passo
+            if constexpr (InLane) {
+                progress[row] = selectFloat(moving, selectFloat(crosses, corner, current + speed), current);
+                anchorSpeed[row] = selectFloat(moving, -1.0f, oldSpeed);
+            } else {
+                // O progresso vem da âncora em vez de acumulado, para que advanceEnemyTo() chegue ao mesmo
+                // valor sem passar por cada tick; a âncora é refeita quando a velocidade muda
+                const float oldAnchor = anchorProgress[row];
+                const int oldTick = anchorTick[row];
+                const bool reanchor = speed != oldSpeed;
+                const float fromProgress = selectFloat(reanchor, current, oldAnchor);
+                const int fromTick = reanchor ? frame : oldTick;
+                const float elapsed = selectFloat(reanchor, 1.0f, (float)(frame + 1 - oldTick));
+                const float advanced = fromProgress + speed * elapsed;
+                progress[row] = selectFloat(moving, selectFloat(crosses, corner, advanced), current);
+                anchorProgress[row] = selectFloat(moving, selectFloat(crosses, corner, fromProgress), oldAnchor);
+                anchorTick[row] = moving ? (crosses ? frame + 1 : fromTick) : oldTick;
+                anchorSpeed[row] = selectFloat(moving, speed, oldSpeed);
+            }
+            health[row] = selectFloat(exits, 0.0f, oldHealth);
+            crossed[row] = moving & crosses;
+            exited += exits;
+        }
+        return exited;
+    }
+
+    // Movimento ao longo do caminho em três passadas. A primeira busca a próxima quina de cada linha (e o
+    // freio da multidão, que fica no Enemy); a segunda é stepAlongPath(); a terceira, escalar, avança
+    // pathIndex de quem atravessou uma quina e refaz a posição pela tabela de busca. InLane (separação
+    // de multidão) acumula o progresso e descarta a âncora, que é refeita quando a separação é desligada
+    template <bool Slowed, bool InLane>
+    static void followPathRows(EnemyTable& table) {
+        const size_t count = table.enemies.size();
+        Enemy* enemies = table.enemies.data();
+        kernelCorners.resize(count);
+        kernelFlags.resize(count);
+        if constexpr (InLane) kernelBrakes.resize(count);
+        float* corners = kernelCorners.data();
+        float* brakes = kernelBrakes.data();
+        int* crossed = kernelFlags.data();
+
+        const int last = (int)pathCorners.size() - 1;
+        for (size_t row = 0; row < count; row++) {
+            int index = enemies[row].pathIndex;
+            corners[row] = index < last ? pathCorners[index + 1] : PATH_END;
+            if constexpr (InLane) brakes[row] = enemies[row].crowdBrake;
+        }
+
+        EnemyColumns& state = table.state;
+        float* health = state.health.data();
+        const Slow* slows = Slowed ? table.column<Slow>().data() : nullptr;
+        enemiesReachedExit(stepAlongPath<Slowed, InLane>(count, corners, brakes, slows, state.speed.data(),
+            state.progress.data(), state.anchorProgress.data(), state.anchorSpeed.data(),
+            state.anchorTick.data(), health, crossed, frameCount));
+
+        const float* progress = state.progress.data();
+        for (size_t row = 0; row < count; row++) {
+            if (health[row] <= 0) continue; // Morreu antes do movimento ou saiu agora: fica onde está
+            enemies[row].pathIndex += crossed[row];
+            enemies[row].placeOnPath(progress[row]);
+        }
+    }
+
+    // Modo labirinto: o flow field é uma consulta por célula cheia de desvios, então este laço é escalar
+    template <bool Slowed>
+    static void followFlowFieldRows(EnemyTable& table) {
+        const size_t count = table.enemies.size();
+        Enemy* enemies = table.enemies.data();
+        const float* speeds = table.state.speed.data();
+        float* health = table.state.health.data();
+        const Slow* slows = Slowed ? table.column<Slow>().data() : nullptr;
+        int exits = 0;
+        for (size_t row = 0; row < count; row++) {
+            if (health[row] <= 0) continue;
+            float speed = speeds[row];
+            if constexpr (Slowed) speed *= slowFactorFor(slows[row].factor, traits.slowResistance);
+            bool exited;
+            if constexpr (traits.flying) exited = enemies[row].flyToExit(speed);
+            else exited = enemies[row].followFlowField(speed);
+            if (exited) {
+                health[row] = 0;
+                exits++;
+            }
+        }
+        enemiesReachedExit(exits);
+    }
+
+    // O modo de movimento e a presença de Slow são resolvidos uma vez por lote
+    template <bool Slowed>
+    static void moveRows(EnemyTable& table) {
+        if (simConfig.mazeMode) followFlowFieldRows<Slowed>(table);
+        else if (simConfig.crowdSeparation) followPathRows<Slowed, true>(table);
+        else followPathRows<Slowed, false>(table);
+    }
+
+    static void move(EnemyTable& table) {
+        if (table.has<Slow>()) moveRows<true>(table);
+        else moveRows<false>(table);
+    }
+
+    // Queimadura em duas passadas: o passo mascarado sobre a coluna de vida (com a armadura do tipo como
+    // constante, vetorizado) marca quem morreu, e a coleta das mortes soma a recompensa num acumulador do
+    // lote, aplicado a money uma vez, e solta os surtos de partículas
+    static void burn(EnemyTable& table) {
+        const size_t count = table.enemies.size();
+        float* health = table.state.health.data();
+        const Burn* burns = table.column<Burn>().data();
+        kernelFlags.resize(count);
+        int* died = kernelFlags.data();
+        for (size_t row = 0; row < count; row++) {
+            const float before = health[row];
+            const float after = before - burns[row].damagePerTick * (1.0f - traits.armor);
+            const bool alive = before > 0;
+            health[row] = alive ? after : before;
+            died[row] = alive & (after <= 0);
+        }
+
+        const Enemy* enemies = table.enemies.data();
+        const float* rewards = table.state.reward.data();
+        float earned = 0.0f;
+        for (size_t row = 0; row < count; row++) {
+            if (!died[row]) continue;
+            earned += rewards[row];
+            emitParticles(PARTICLE_DEATH, enemies[row].position, enemies[row].color);
+        }
+        money += earned;
+    }
+};
+
+struct EnemyKindKernels {
+    EnemyBatchKernel move;
+    EnemyBatchKernel burn;
+};
+
+template <size_t... Kinds>
+constexpr std::array<EnemyKindKernels, sizeof...(Kinds)> makeEnemyKernels(std::index_sequence<Kinds...>) {
+    return {{{&EnemyKernels<(int)Kinds>::move, &EnemyKernels<(int)Kinds>::burn}...}};
+}
+
+// Tabela de despacho gerada para todos os EnemyKind
+constexpr auto enemyKernels = makeEnemyKernels(std::make_index_sequence<ENEMY_KIND_COUNT>());
+
+// Sistema de efeitos: queimadura causa dano por tick; efeitos vencidos são removidos (adiado)
+void updateStatusEffects() {
+    PROFILE_ZONE("updateStatusEffects");
+    forEachOccupiedTable([](EnemyTable& table) {
+        if (table.has<Burn>()) enemyKernels[table.kind].burn(table);
+    });
+    forEachEnemy<Burn>([](Enemy& enemy, Burn& burn) {
+        if (frameCount >= burn.untilTick) deferRemoveComponent<Burn>(enemy.id);
+    });
+    forEachEnemy<Slow>([](Enemy& enemy, Slow& slow) {
+        if (frameCount >= slow.untilTick) deferRemoveComponent<Slow>(enemy.id);
+    });
+}
+
+// Sistema de movimento: um kernel por tabela, escolhido pelo tipo de inimigo (dormentes não andam por tick)
+void moveEnemies() {
+    PROFILE_ZONE("moveEnemies");
+    forEachOccupiedTable([](EnemyTable& table) {
+        if (!table.has<Dormant>()) enemyKernels[table.kind].move(table);
+    });
+}
+
+// Atualiza os projéteis teleguiados e remove os que acertaram ou perderam o alvo
+void updateProjectiles() {
+    PROFILE_ZONE("projectiles.erase");
+    projectiles.erase(
+        std::remove_if(projectiles.begin(), projectiles.end(),
+            [](Projectile& p) {
+                p.update();
+                return p.damage <= 0 || p.hasHit;
+            }),
+        projectiles.end()
+    );
+}
+
+void update() {
+    if (gameOver) return;
+    PROFILE_ZONE("update");
+    AllocationScope allocationScope(ALLOC_SCOPE_UPDATE);
+
+    // Eventos vencidos neste tick: lotes de inimigos e torres que terminaram de recarregar
+    simTimers.advance(frameCount, [](const TimerEvent& event) {
+        switch (event.kind) {
+            case TIMER_SPAWN:
+                if (waveInProgress && enemiesLeftToSpawn > 0) spawnEnemyBatch(frameCount + 1);
+                break;
+            case TIMER_TOWER_READY:
+                readyTowers.push_back(event.payload);
+                break;
+            case TIMER_PROJECTILE_IMPACT:
+                resolveBallisticImpact(event.payload);
+                break;
+            case TIMER_ENEMY_WAKE:
+                resolveEnemyWake(event.payload);
+                break;
+            default:
+                break;
+        }
+    });
+    flushEnemyCommands();
+
+    // Só torres prontas procuram alvo (em ordem de índice, como a varredura completa); as que
+    // atiram voltam para a roda e as demais continuam prontas. Sem inimigos, nada é feito
+    if (!readyTowers.empty() && enemyCount() > 0) {
+        PROFILE_ZONE("Tower::update");
+        std::sort(readyTowers.begin(), readyTowers.end());
+        bool indexed = useProgressIndex(readyTowers.size());
+        if (indexed) {
+            buildProgressIndex();
+        }
+        size_t stillReady = 0;
+        for (unsigned int index : readyTowers) {
+            if (towers[index].update(projectiles, frameCount, indexed)) {
+                scheduleTowerReady(index);
+            } else {
+                readyTowers[stillReady++] = index;
+            }
+        }
+        readyTowers.resize(stillReady);
+    }
+
+    updateProjectiles();
+    flushEnemyCommands();
+
+    // Efeitos de estado e movimento; mortos e linhas movidas de arquétipo saem na compactação
+    updateStatusEffects();
+    if (simConfig.crowdSeparation && !simConfig.mazeMode) {
+        separateCrowd();
+    }
+    moveEnemies();
+    updatePathLod();
+    flushEnemyCommands();
+    compactEnemyTables();
+
+    // Verificar fim da onda
+    if (waveInProgress && enemyCount() == 0 && enemiesLeftToSpawn == 0) {
+        waveInProgress = false;
+        if (currentWave >= simConfig.maxWaves) {
+            gameOver = true;
+        }
+    }
+
+    frameCount++;
+}
+
+// ===================== Snapshots do estado da simulação =====================
+
+// Snapshot binário compacto de toda a simulação: economia, contadores de onda, semente do RNG,
+// inimigos, torres e projéteis (alvos guardados como handles de inimigo)
+const unsigned int SNAPSHOT_MAGIC = 0x39534454; // "TDS9" (estado dos inimigos em colunas)
+
+static_assert(std::is_trivially_copyable<Enemy>::value, "Enemy precisa ser copiável byte a byte");
+static_assert(std::is_trivially_copyable<Slow>::value && std::is_trivially_copyable<Burn>::value,
+              "Componentes precisam ser copiáveis byte a byte");
+static_assert(std::is_trivially_copyable<Projectile>::value, "Projectile precisa ser copiável byte a byte");
+static_assert(std::is_trivially_copyable<Tower>::value, "Tower precisa ser copiável byte a byte");
+
+template <typename T>
+void writePod(std::vector<unsigned char>& buffer, const T& value) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+void writePodArray(std::vector<unsigned char>& buffer, const std::vector<T>& values) {
+    writePod(buffer, (unsigned int)values.size());
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values.data());
+    buffer.insert(buffer.end(), bytes, bytes + values.size() * sizeof(T));
+}
+
+// Leitor sequencial com verificação de limites
+struct SnapshotReader {
+    const std::vector<unsigned char>& buffer;
+    size_t offset = 0;
+    bool ok = true;
+
+    explicit SnapshotReader(const std::vector<unsigned char>& buffer) : buffer(buffer) {}
+
+    template <typename T>
+    T read() {
+        T value{};
+        if (offset + sizeof(T) > buffer.size()) {
+            ok = false;
+            return value;
+        }
+        std::memcpy(&value, buffer.data() + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+    template <typename T>
+    void readArray(std::vector<T>& values) {
+        unsigned int count = read<unsigned int>();
+        if (!ok || offset + (size_t)count * sizeof(T) > buffer.size()) {
+            ok = false;
+            return;
+        }
+        // Enemy e Projectile não têm construtor padrão: copia elemento a elemento via armazenamento alinhado
+        values.clear();
+        values.reserve(count);
+        alignas(T) unsigned char storage[sizeof(T)];
+        for (unsigned int i = 0; i < count; i++) {
+            std::memcpy(storage, buffer.data() + offset, sizeof(T));
+            values.push_back(*reinterpret_cast<const T*>(storage));
+            offset += sizeof(T);
+        }
+    }
+};
+
+// Escreve o estado da simulação no buffer (reaproveita a capacidade já alocada)
+void captureSnapshot(std::vector<unsigned char>& buffer) {
+    buffer.clear();
+    writePod(buffer, SNAPSHOT_MAGIC);
+    writePod(buffer, money);
+    writePod(buffer, lives);
+    writePod(buffer, currentWave);
+    writePod(buffer, waveInProgress);
+    writePod(buffer, gameOver);
+    writePod(buffer, frameCount);
+    writePod(buffer, lastEnemySpawnTime);
+    writePod(buffer, enemiesLeftToSpawn);
+    writePod(buffer, nextEnemyId);
+    writePod(buffer, simulationSeed);
+    for (auto& table : enemyTables) {
+        writePodArray(buffer, table.enemies);
+        table.state.forEachColumn([&](const auto& column) { writePodArray(buffer, column); });
+        std::apply([&](auto&... columns) { (writePodArray(buffer, columns), ...); }, table.components);
+    }
+    writePodArray(buffer, projectiles);
+    writePodArray(buffer, ballisticProjectiles);
+    writePodArray(buffer, towers);
+}
+
+// Restaura o estado da simulação; em caso de buffer inválido o estado atual não é alterado
+bool restoreSnapshot(const std::vector<unsigned char>& buffer) {
+    SnapshotReader in(buffer);
+    if (in.read<unsigned int>() != SNAPSHOT_MAGIC) return false;
+
+    float newMoney = in.read<float>();
+    int newLives = in.read<int>();
+    int newWave = in.read<int>();
+    bool newWaveInProgress = in.read<bool>();
+    bool newGameOver = in.read<bool>();
+    int newFrameCount = in.read<int>();
+    int newLastSpawn = in.read<int>();
+    int newLeftToSpawn = in.read<int>();
+    unsigned int newNextEnemyId = in.read<unsigned int>();
+    unsigned int newSeed = in.read<unsigned int>();
+    EnemyTable newTables[ENEMY_ARCHETYPE_COUNT];
+    for (int i = 0; i < ENEMY_ARCHETYPE_COUNT; i++) {
+        EnemyTable& table = newTables[i];
+        table.kind = (unsigned char)(i / ENEMY_COMPONENT_SETS);
+        table.mask = (unsigned char)(i % ENEMY_COMPONENT_SETS);
+        in.readArray(table.enemies);
+        bool columnsOk = true;
+        table.state.forEachColumn([&](auto& column) {
+            in.readArray(column);
+            if (column.size() != table.enemies.size()) columnsOk = false;
+        });
+        std::apply([&](auto&... columns) {
+            auto read = [&](auto& column) {
+                using T = typename std::decay_t<decltype(column)>::value_type;
+                in.readArray(column);
+                size_t expected = table.has<T>() ? table.enemies.size() : 0;
+                if (column.size() != expected) columnsOk = false;
+            };
+            (read(columns), ...);
+        }, table.components);
+        for (const auto& enemy : table.enemies) {
+            if (enemy.id == 0 || enemy.id >= newNextEnemyId || enemy.kind != table.kind) columnsOk = false;
+        }
+        if (!columnsOk) return false;
+    }
+    std::vector<Projectile> newProjectiles;
+    std::vector<BallisticProjectile> newBallisticProjectiles;
+    in.readArray(newProjectiles);
+    in.readArray(newBallisticProjectiles);
+
+    std::vector<Tower> newTowers;
+    in.readArray(newTowers);
+    if (!in.ok) return false;
+    for (auto& tower : newTowers) {
+        if (tower.type >= TOWER_TYPE_COUNT) return false;
+        tower.updateDimensions(); // A janela pode ter mudado desde a captura
+    }
+
+    money = newMoney;
+    lives = newLives;
+    currentWave = newWave;
+    waveInProgress = newWaveInProgress;
+    gameOver = newGameOver;
+    frameCount = newFrameCount;
+    lastEnemySpawnTime = newLastSpawn;
+    enemiesLeftToSpawn = newLeftToSpawn;
+    nextEnemyId = newNextEnemyId;
+    simulationSeed = newSeed;
+    clearEnemyTables();
+    for (int i = 0; i < ENEMY_ARCHETYPE_COUNT; i++) {
+        std::swap(enemyTables[i], newTables[i]);
+        for (unsigned int row = 0; row < enemyTables[i].enemies.size(); row++) {
+            setEnemyLocation(enemyTables[i].enemies[row].id, (unsigned char)i, row);
+        }
+        updateTableOccupancy(i);
+    }
+    projectiles.swap(newProjectiles);
+    ballisticProjectiles.swap(newBallisticProjectiles);
+    towers.swap(newTowers);
+    rebuildMapGrids();
+    rebuildSimTimers();
+    return true;
+}
+
+// Anel de snapshots em memória tirados a cada N ticks para o rewind
+const int SNAPSHOT_INTERVAL_TICKS = 300;    // ~5 segundos a 60 FPS
+const int SNAPSHOT_RING_CAPACITY = 64;      // ~5 minutos de histórico
+const int REWIND_MIN_TICKS_BACK = 30;       // Apertar de novo logo após um rewind volta mais um snapshot
+
+struct SnapshotRing {
+    std::vector<std::vector<unsigned char>> slots;
+    std::vector<int> slotFrame;
+    int newest = -1;
+    int count = 0;
+    int lastCaptureFrame = -1;
+
+    // Métricas do custo de captura (microssegundos)
+    double lastCaptureUs = 0.0;
+    double maxCaptureUs = 0.0;
+    double totalCaptureUs = 0.0;
+    int captures = 0;
+
+    SnapshotRing() : slots(SNAPSHOT_RING_CAPACITY), slotFrame(SNAPSHOT_RING_CAPACITY, -1) {}
+
+    void clear() {
+        newest = -1;
+        count = 0;
+        lastCaptureFrame = -1;
+    }
+
+    // Chamado depois de cada tick da simulação
+    void onTick() {
+        if (frameCount == lastCaptureFrame || frameCount % SNAPSHOT_INTERVAL_TICKS != 0) return;
+
+        auto start = std::chrono::steady_clock::now();
+        newest = (newest + 1) % SNAPSHOT_RING_CAPACITY;
+        captureSnapshot(slots[newest]);
+        slotFrame[newest] = frameCount;
+        count = std::min(count + 1, SNAPSHOT_RING_CAPACITY);
+        lastCaptureFrame = frameCount;
+
+        lastCaptureUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        maxCaptureUs = std::max(maxCaptureUs, lastCaptureUs);
+        totalCaptureUs += lastCaptureUs;
+        captures++;
+    }
+
+    // Restaura o snapshot mais recente anterior ao tick atual e descarta os que ficaram "no futuro".
+    // Retorna o tick restaurado ou -1 se não houver histórico
+    int rewind() {
+        while (count > 0) {
+            int slot = newest;
+            newest = (newest - 1 + SNAPSHOT_RING_CAPACITY) % SNAPSHOT_RING_CAPACITY;
+            count--;
+            if (slotFrame[slot] <= frameCount - REWIND_MIN_TICKS_BACK && restoreSnapshot(slots[slot])) {
+                // Mantém o snapshot restaurado no anel para permitir repetir o mesmo trecho
+                newest = slot;
+                count++;
+                lastCaptureFrame = frameCount;
+                return frameCount;
+            }
+        }
+        return -1;
+    }
+
+    double averageCaptureUs() const { return captures > 0 ? totalCaptureUs / captures : 0.0; }
+};
+
+SnapshotRing snapshotRing;
+
+void rewindToSnapshot() {
+    auto start = std::chrono::steady_clock::now();
+    int frame = snapshotRing.rewind();
+    double restoreUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    if (frame < 0) {
+        showFeedback("Nenhum snapshot para voltar");
+        return;
+    }
+    showFeedback(frameFormat("Voltou para o tick %d (%.0f us)", frame, restoreUs));
+}
+
+// ===================== Partículas na GPU =====================
+
+// As partículas vivem num anel de buffers na GPU e são atualizadas por transform feedback (ping-pong
+// entre dois buffers), sem passar pela CPU. A CPU só envia os surtos do frame como uniforms e acompanha
+// qual trecho do anel ainda pode ter partículas vivas: como a emissão avança em ordem e nenhuma
+// partícula vive mais que PARTICLE_MAX_LIFE, só esse trecho é atualizado e desenhado. Em GL por
+// software (llvmpipe, SwiftShader...) a capacidade e o tamanho dos surtos caem para não travar o jogo
+const int PARTICLE_CAPACITY = 1 << 18;          // 262144 partículas (10 MB nos dois buffers)
+const int PARTICLE_CAPACITY_SOFTWARE = 1 << 13;
+const float PARTICLE_MAX_LIFE = 1.0f;           // Segundos; a duração de cada surto não passa disso
+const int PARTICLE_FLOATS = 10;                 // Posição e velocidade (4), cor (4), idade e duração (2)
+const int PARTICLE_EMIT_MARKS = 256;            // Frames com emissão lembrados para achar o fim do trecho vivo
+
+struct ParticleBurstStyle {
+    int count;      // Partículas por surto
+    float speed;    // Velocidade máxima (px/s em 720p)
+    float life;     // Duração máxima (s)
+};
+
+const ParticleBurstStyle particleBurstStyles[PARTICLE_BURST_KIND_COUNT] = {
+    {48, 260.0f, 0.35f},   // PARTICLE_HIT
+    {160, 180.0f, 0.9f},   // PARTICLE_DEATH
+};
+
+struct ParticleSystem {
+    bool enabled = false;
+    bool software = false;
+    int capacity = PARTICLE_CAPACITY; // --particles; 0 desliga
+    int burstScale = 1;               // Divisor do tamanho dos surtos (software)
+    unsigned int updateProgram = 0;
+    unsigned int drawProgram = 0;
+    unsigned int buffers[2] = {};
+    unsigned int vaos[2] = {};
+    int current = 0;                  // Buffer com o estado mais recente
+    long long emitted = 0;            // Partículas emitidas desde o início (a posição no anel é emitted % capacity)
+    long long aliveFrom = 0;          // Todas as emitidas antes desta já morreram
+    struct EmitMark {
+        double time;
+        long long firstEmitted;
+    } marks[PARTICLE_EMIT_MARKS];
+    int markStart = 0;
+    int markCount = 0;
+    unsigned int frameSeed = 0;
+    std::chrono::steady_clock::time_point lastUpdate;
+    // Uniforms
+    int dtLoc, capacityLoc, emitStartLoc, emitCountLoc, burstCountLoc, burstShapeLoc, burstColorLoc, burstFirstLoc, seedLoc;
+    int pointScaleLoc;
+};
+
+ParticleSystem particleSystem;
+
+long long liveParticleCount() {
+    return particleSystem.enabled ? particleSystem.emitted - particleSystem.aliveFrom : 0;
+}
+
+bool isSoftwareRenderer() {
+    const char* renderer = (const char*)glGetString(GL_RENDERER);
+    if (!renderer) return false;
+    for (const char* name : {"llvmpipe", "softpipe", "SwiftShader", "Software", "GDI Generic"}) {
+        if (std::strstr(renderer, name)) return true;
+    }
+    return false;
+}
+
+// Programa só com vertex shader, cujas saídas são gravadas intercaladas no buffer de transform feedback
+unsigned int createTransformFeedbackProgram(const char* vsSource, const char* const* varyings, int varyingCount) {
+    unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vsSource);
+    unsigned int program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glTransformFeedbackVaryings(program, varyingCount, varyings, GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);
+
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        LOG_ERROR("shader", "erro de linkagem (transform feedback): %s", infoLog);
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void destroyParticleSystem() {
+    ParticleSystem& system = particleSystem;
+    particleEmission = false;
+    if (system.updateProgram) glDeleteProgram(system.updateProgram);
+    if (system.drawProgram) glDeleteProgram(system.drawProgram);
+    if (system.vaos[0]) glDeleteVertexArrays(2, system.vaos);
+    if (system.buffers[0]) glDeleteBuffers(2, system.buffers);
+    system.updateProgram = system.drawProgram = 0;
+    system.vaos[0] = system.vaos[1] = system.buffers[0] = system.buffers[1] = 0;
+    system.enabled = false;
+}
+
+// Chamada por initOpenGL(); se algo falhar o jogo segue sem partículas
+void initParticleSystem() {
+    PROFILE_ZONE("initParticleSystem");
+    ParticleSystem& system = particleSystem;
+    if (system.capacity <= 0) return;
+    system.software = isSoftwareRenderer();
+    if (system.software) {
+        system.capacity = std::min(system.capacity, PARTICLE_CAPACITY_SOFTWARE);
+        system.burstScale = 4;
+        LOG_WARN("particulas", "renderizador por software: capacidade reduzida para %d", system.capacity);
+    }
+
+    const char* const varyings[] = {"outMotion", "outColor", "outAgeLife"};
+    system.updateProgram = createTransformFeedbackProgram(particleUpdateShaderSource, varyings, 3);
+    system.drawProgram = createAndLinkShaderProgram(particleVertexShaderSource, particleFragmentShaderSource);
+    int linked = 0;
+    if (system.drawProgram) glGetProgramiv(system.drawProgram, GL_LINK_STATUS, &linked);
+    if (!system.updateProgram || !linked) {
+        LOG_WARN("particulas", "shaders de partículas indisponíveis; efeitos desligados");
+        destroyParticleSystem();
+        return;
+    }
+
+    // Buffers zerados: idade 0 e duração 0 é uma partícula morta
+    const GLsizeiptr bytes = (GLsizeiptr)system.capacity * PARTICLE_FLOATS * sizeof(float);
+    const GLsizei stride = PARTICLE_FLOATS * sizeof(float);
+    std::vector<float> zeros((size_t)system.capacity * PARTICLE_FLOATS, 0.0f);
+    glGenVertexArrays(2, system.vaos);
+    glGenBuffers(2, system.buffers);
+    for (int i = 0; i < 2; i++) {
+        glBindVertexArray(system.vaos[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, system.buffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, bytes, zeros.data(), GL_DYNAMIC_COPY);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)(4 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(8 * sizeof(float)));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    unsigned int program = system.updateProgram;
+    system.dtLoc = glGetUniformLocation(program, "dt");
+    system.capacityLoc = glGetUniformLocation(program, "capacity");
+    system.emitStartLoc = glGetUniformLocation(program, "emitStart");
+    system.emitCountLoc = glGetUniformLocation(program, "emitCount");
+    system.burstCountLoc = glGetUniformLocation(program, "burstCount");
+    system.burstShapeLoc = glGetUniformLocation(program, "burstShape");
+    system.burstColorLoc = glGetUniformLocation(program, "burstColor");
+    system.burstFirstLoc = glGetUniformLocation(program, "burstFirst");
+    system.seedLoc = glGetUniformLocation(program, "seed");
+    system.pointScaleLoc = glGetUniformLocation(system.drawProgram, "pointScale");
+
+    system.current = 0;
+    system.emitted = system.aliveFrom = 0;
+    system.markStart = system.markCount = 0;
+    system.lastUpdate = std::chrono::steady_clock::now();
+    system.enabled = true;
+    particleEmission = true;
+    particleBurstCount = 0;
+}
+
+// Roda o programa ligado sobre o trecho vivo do anel, que pode dar a volta no fim do buffer
+template <typename Draw>
+void forEachLiveParticleRange(Draw draw) {
+    const ParticleSystem& system = particleSystem;
+    long long live = system.emitted - system.aliveFrom;
+    int first = (int)(system.aliveFrom % system.capacity);
+    int count = (int)std::min<long long>(live, system.capacity - first);
+    if (count > 0) draw(first, count);
+    if (live > count) draw(0, (int)(live - count));
+}
+
+void updateAndDrawParticles() {
+    ParticleSystem& system = particleSystem;
+    if (!system.enabled) return;
+    PROFILE_ZONE("updateAndDrawParticles");
+
+    auto now = std::chrono::steady_clock::now();
+    float dt = std::min(0.1f, std::chrono::duration<float>(now - system.lastUpdate).count());
+    system.lastUpdate = now;
+    double seconds = std::chrono::duration<double>(now.time_since_epoch()).count();
+
+    // Surtos do tick: cada um ocupa um trecho consecutivo do anel a partir de emitStart
+    float heightRatio = WINDOW_HEIGHT / 720.0f;
+    float burstShape[MAX_PARTICLE_BURSTS * 4];
+    float burstColor[MAX_PARTICLE_BURSTS * 4];
+    int burstFirst[MAX_PARTICLE_BURSTS];
+    int burstCount = 0;
+    int emitCount = 0;
+    for (int i = 0; i < particleBurstCount; i++) {
+        const ParticleBurst& burst = particleBursts[i];
+        const ParticleBurstStyle& style = particleBurstStyles[burst.kind];
+        int count = std::max(1, style.count / system.burstScale);
+        if (emitCount + count > system.capacity) break;
+        float* shape = &burstShape[burstCount * 4];
+        shape[0] = burst.position.x;
+        shape[1] = burst.position.y;
+        shape[2] = style.speed * heightRatio;
+        shape[3] = std::min(style.life, PARTICLE_MAX_LIFE);
+        float* color = &burstColor[burstCount * 4];
+        color[0] = burst.color.r;
+        color[1] = burst.color.g;
+        color[2] = burst.color.b;
+        color[3] = burst.color.a;
+        burstFirst[burstCount++] = emitCount;
+        emitCount += count;
+    }
+    particleBurstCount = 0;
+    int emitStart = (int)(system.emitted % system.capacity);
+    if (emitCount > 0) {
+        if (system.markCount == PARTICLE_EMIT_MARKS) {
+            // Sem espaço: estende a marca mais nova (conservador, o trecho vivo só fica maior)
+            system.marks[(system.markStart + system.markCount - 1) % PARTICLE_EMIT_MARKS].time = seconds;
+        } else {
+            system.marks[(system.markStart + system.markCount++) % PARTICLE_EMIT_MARKS] = {seconds, system.emitted};
+        }
+        system.emitted += emitCount;
+    }
+
+    // Fim do trecho vivo: a emissão mais antiga que ainda pode ter partículas vivas
+    while (system.markCount > 0 && system.marks[system.markStart].time < seconds - PARTICLE_MAX_LIFE) {
+        system.markStart = (system.markStart + 1) % PARTICLE_EMIT_MARKS;
+        system.markCount--;
+    }
+    system.aliveFrom = system.markCount > 0 ? system.marks[system.markStart].firstEmitted : system.emitted;
+    system.aliveFrom = std::max(system.aliveFrom, system.emitted - system.capacity); // Anel cheio: as mais antigas dão lugar
+    if (system.emitted == system.aliveFrom) return;
+
+    // Atualização: lê do buffer atual e grava no outro, na mesma posição do anel
+    const GLsizeiptr stride = PARTICLE_FLOATS * sizeof(float);
+    int target = 1 - system.current;
+    glUseProgram(system.updateProgram);
+    glUniform1f(system.dtLoc, dt);
+    glUniform1i(system.capacityLoc, system.capacity);
+    glUniform1i(system.emitStartLoc, emitStart);
+    glUniform1i(system.emitCountLoc, emitCount);
+    glUniform1i(system.burstCountLoc, burstCount);
+    if (burstCount > 0) {
+        glUniform4fv(system.burstShapeLoc, burstCount, burstShape);
+        glUniform4fv(system.burstColorLoc, burstCount, burstColor);
+        glUniform1iv(system.burstFirstLoc, burstCount, burstFirst);
+    }
+    glUniform1ui(system.seedLoc, ++system.frameSeed * 0x9e3779b9u);
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(system.vaos[system.current]);
+    forEachLiveParticleRange([&](int first, int count) {
+        glBindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, system.buffers[target], first * stride, count * stride);
+        glBeginTransformFeedback(GL_POINTS);
+        glDrawArrays(GL_POINTS, first, count);
+        glEndTransformFeedback();
+    });
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glDisable(GL_RASTERIZER_DISCARD);
+    system.current = target;
+
+    // Desenho com blend aditivo: faíscas sobrepostas brilham mais
+    glUseProgram(system.drawProgram);
+    setProjectionMatrix(system.drawProgram);
+    glUniform1f(system.pointScaleLoc, 6.0f * heightRatio);
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    glBindVertexArray(system.vaos[system.current]);
+    forEachLiveParticleRange([](int first, int count) {
+        glDrawArrays(GL_POINTS, first, count);
+    });
+    glBindVertexArray(0);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_PROGRAM_POINT_SIZE);
+}
+
+// Preview da torre sendo colocada. É o último desenho do frame para que a posição do cursor seja
+// amostrada o mais tarde possível antes do swap
+void drawPlacementPreview() {
+    if (placingTowerType == NO_TOWER_TYPE) {
+        latchCursorEvents(false);
+        return;
+    }
+    // Late latching: o cursor é lido só agora, depois do mundo, da interface e do HUD
+    double mouseX_local, mouseY_local;
+    glfwGetCursorPos(glfwGetCurrentContext(), &mouseX_local, &mouseY_local);
+    latchCursorEvents(true);
+    
+    // Inverter Y para coordenadas OpenGL
+    mouseY_local = WINDOW_HEIGHT - mouseY_local;
+    
+    // Ajustar o raio e alcance proporcionalmente ao tamanho da janela
+    float heightRatio = static_cast<float>(WINDOW_HEIGHT) / 720.0f;
+    float previewRadius = 20.0f * heightRatio;
+    float previewRange = towerTypes[placingTowerType].range * heightRatio;
+    
+    // Primeiro desenhar o círculo de alcance (mais transparente)
+    Color rangeColor(0.5f, 0.5f, 0.5f, 0.3f); // Cor mais visível para o range
+    drawCircle((float)mouseX_local, (float)mouseY_local, previewRange, rangeColor);
+
+    // Destacar os trechos do caminho que a torre cobriria
+    if (!simConfig.mazeMode) {
+        PathInterval coverage[MAX_COVERAGE_INTERVALS];
+        int coverageCount = computePathCoverage(Point((float)mouseX_local, (float)mouseY_local),
+                                                towerTypes[placingTowerType].range, coverage);
+        Color coverageColor = towerTypes[placingTowerType].color;
+        coverageColor.a = 0.8f;
+        for (int i = 0; i < coverageCount; i++) {
+            drawPathInterval(coverage[i], coverageColor, 9.0f);
+        }
+    }
+    
+    // Depois desenhar a torre (vermelha se a posição for inválida)
+    Color previewColor = isPlacementFree((float)mouseX_local, (float)mouseY_local)
+        ? towerTypes[placingTowerType].color : Color(0.9f, 0.2f, 0.2f);
+    previewColor.a = 0.7f; // Aumentar opacidade
+    drawCircle((float)mouseX_local, (float)mouseY_local, previewRadius, previewColor);
+    
+    // Não precisamos mais desenhar o contorno separadamente já que o círculo de range já está visível
+}
+
+void render() {
+    PROFILE_ZONE("render");
+    AllocationScope allocationScope(ALLOC_SCOPE_RENDER);
+    glClearColor(0.1f, 0.12f, 0.15f, 1.0f); // Nova cor de fundo
+    glClear(GL_COLOR_BUFFER_BIT);
+    glEnable(GL_BLEND); // Habilitar blend para texto e formas transparentes
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    
+    // Desenhar caminho
+    drawPath();
+    
+    // Desenhar torres
+    for (const auto& tower : towers) {
+        drawTower(tower);
+    }
+    
+    // Desenhar projéteis
+    for (const auto& projectile : projectiles) {
+        drawProjectile(projectile, projectile.position);
+    }
+    for (const auto& projectile : ballisticProjectiles) {
+        if (!projectile.shot.hasHit) drawProjectile(projectile.shot, projectile.positionAt(frameCount));
+    }
+    
+    // Desenhar inimigos (anéis indicam lentidão e queimadura); a posição dos dormentes vem da âncora
+    forEachOccupiedTable([](EnemyTable& table) {
+        for (size_t row = 0; row < table.enemies.size(); row++) {
+            if (table.has<Dormant>() && table.state.health[row] > 0) advanceEnemyTo(table, row, frameCount);
+            drawEnemy(table.enemies[row], table.state.health[row]);
+        }
+    });
+    forEachEnemy<Slow>([](const Enemy& enemy, const Slow&) {
+        drawCircle(enemy.position.x, enemy.position.y, enemy.radius * 0.45f, Color(0.6f, 0.95f, 1.0f, 0.9f));
+    });
+    forEachEnemy<Burn>([](const Enemy& enemy, const Burn&) {
+        drawCircle(enemy.position.x, enemy.position.y, enemy.radius * 0.25f, Color(1.0f, 0.3f, 0.15f, 0.9f));
+    });
+
+    // Faíscas de impacto e de morte (surtos deste tick entram aqui)
+    updateAndDrawParticles();
+    
+    // Áreas livres para a torre sendo colocada; o preview que segue o cursor vem no fim do frame
+    if (placingTowerType != NO_TOWER_TYPE) {
+        drawPlacementOverlay();
+    }
+    
+    // Desenhar interface
+    drawUI();
+    if (perfHud.visible) drawPerfHud();
+
+    drawPlacementPreview();
+}
+
+// Alterna o modo labirinto; reinicia a partida, pois torres e inimigos dependem do modo
+void toggleMazeMode() {
+    if (waveInProgress) {
+        showFeedback("Aguarde o fim da onda para trocar o modo");
+        return;
+    }
+    simConfig.mazeMode = !simConfig.mazeMode;
+    initGame();
+    snapshotRing.clear();
+    showFeedback(simConfig.mazeMode ? "Modo labirinto ativado" : "Modo labirinto desativado");
+}
+
+// Pode ser trocada a qualquer momento: os inimigos voltam ao centro e a cobertura das torres é refeita
+void toggleCrowdSeparation() {
+    simConfig.crowdSeparation = !simConfig.crowdSeparation;
+    forEachEnemy<>([](Enemy& enemy) {
+        enemy.lane = 0.0f;
+        enemy.crowdBrake = 1.0f;
+    });
+    updateTowerDimensions();
+    rebuildPathCoverage();
+    showFeedback(simConfig.crowdSeparation ? "Separação de multidão ativada" : "Separação de multidão desativada");
+}
+
+// Amostras de tempo (ms) com percentis para o relatório
+struct TimingSamples {
+    std::vector<float> samples;
+    double total = 0.0;
+
+    void add(double ms) {
+        samples.push_back((float)ms);
+        total += ms;
+    }
+
+    float percentile(float p) const {
+        if (samples.empty()) return 0.0f;
+        std::vector<float> sorted = samples;
+        size_t index = std::min(sorted.size() - 1, (size_t)(p * (sorted.size() - 1) + 0.5f));
+        std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+        return sorted[index];
+    }
+
+    void print(const char* name) const {
+        if (samples.empty()) return;
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << name << ": média " << total / samples.size() << " ms | p50 " << percentile(0.50f)
+                  << " | p95 " << percentile(0.95f) << " | p99 " << percentile(0.99f)
+                  << " | máx " << *std::max_element(samples.begin(), samples.end()) << " ms" << std::endl;
+    }
+};
+
+// ===================== Sessões gravadas =====================
+
+// Com --record, cada ação do jogador que muda a simulação é gravada com a iteração do loop principal em
+// que foi aplicada, junto com a configuração inicial (resolução, semente, modos e caminho) e o estado
+// final. --replay repete a sessão sem janela visível e confere o estado final (veja runReplays)
+enum SessionActionKind : unsigned char {
+    SESSION_PLACE_TOWER,   // type = tipo da torre, (x, y) em pixels
+    SESSION_START_WAVE,
+    SESSION_RESTART,
+    SESSION_REWIND,
+    SESSION_TOGGLE_MAZE,
+    SESSION_TOGGLE_CROWD,
+    SESSION_RESIZE,        // (x, y) = largura e altura
+    SESSION_ACTION_COUNT
+};
+
+const char* const sessionActionNames[SESSION_ACTION_COUNT] = {
+    "torre", "onda", "reiniciar", "voltar", "labirinto", "multidao", "janela"
+};
+
+struct SessionAction {
+    long long tick;        // Iteração do loop principal (não frameCount, que volta no reinício e no rewind)
+    SessionActionKind kind;
+    int type;
+    float x, y;
+};
+
+struct Session {
+    int width = 1920;
+    int height = 1080;
+    unsigned int seed = 0;
+    SimConfig config;
+    PathShape shape;
+    std::vector<SessionAction> actions;
+    long long ticks = -1;  // Duração; -1 se a gravação não tem a linha "fim"
+    float money = 0.0f;
+    int lives = 0;
+    int wave = 0;
+    size_t enemies = 0;
+};
+
+struct SessionRecorder {
+    bool active = false;
+    std::string fileName;
+    long long startTick = 0;
+    Session session;
+};
+
+SessionRecorder sessionRecorder;
+long long simulationTick = 0; // Ticks da simulação na janela (uma iteração do loop principal cada)
+
+// Chamada depois de initGame(): guarda o ponto de partida da gravação
+void startSessionRecording(const std::string& fileName) {
+    SessionRecorder& recorder = sessionRecorder;
+    recorder.active = true;
+    recorder.fileName = fileName;
+    recorder.startTick = simulationTick;
+    recorder.session = Session();
+    recorder.session.width = WINDOW_WIDTH;
+    recorder.session.height = WINDOW_HEIGHT;
+    recorder.session.seed = simulationSeed;
+    recorder.session.config = simConfig;
+    recorder.session.shape = pathShape;
+}
+
+void applySessionAction(const SessionAction& action) {
+    switch (action.kind) {
+        case SESSION_PLACE_TOWER:
+            placingTowerType = action.type;
+            placeTower(action.x, action.y);
+            break;
+        case SESSION_START_WAVE:
+            startWave();
+            break;
+        case SESSION_RESTART:
+            if (gameOver) {
+                initGame();
+                snapshotRing.clear();
+            }
+            break;
+        case SESSION_REWIND:
+            rewindToSnapshot();
+            break;
+        case SESSION_TOGGLE_MAZE:
+            toggleMazeMode();
+            break;
+        case SESSION_TOGGLE_CROWD:
+            toggleCrowdSeparation();
+            break;
+        case SESSION_RESIZE:
+            resizeWorld((int)action.x, (int)action.y);
+            break;
+        default:
+            break;
+    }
 }
 
-// Implementação completa do callback de redimensionamento
-void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    WINDOW_WIDTH = width;
-    WINDOW_HEIGHT = height;
-    glViewport(0, 0, width, height);
-    updatePath();
-    updateTowerDimensions();
+// Aplica a ação do jogador e a grava se houver gravação
+void performSessionAction(SessionActionKind kind, int type = 0, float x = 0.0f, float y = 0.0f) {
+    SessionAction action = {simulationTick - sessionRecorder.startTick, kind, type, x, y};
+    if (sessionRecorder.active) sessionRecorder.session.actions.push_back(action);
+    applySessionAction(action);
 }
 
-// Declarar protótipos de funções
-void setProjectionMatrix(unsigned int currentShaderProgram);
-void drawCircle(float x, float y, float radius, Color color);
-void drawRectangle(float x, float y, float width, float height, Color color);
-void drawLine(Point start, Point end, Color color, float width);
-void drawHexagon(float x, float y, float radius, Color color); // Novo protótipo
-void RenderText(const std::string& text, float x, float y_baseline, float scale, Color color);
-void initTextRendering();
-void initOpenGL();
-void drawPath();
-void drawEnemy(const Enemy& enemy);
-void drawTower(const Tower& tower);
-void drawProjectile(const Projectile& projectile);
-void drawUI();
-void initGame();
-void spawnWave();
-void startWave();
-bool canPlaceTower(float x, float y);
-void placeTower(float x, float y);
-void selectTowerType(const std::string& type);
-void update();
-void render();
+bool saveSession(const std::string& fileName, const Session& session) {
+    std::ofstream out(fileName);
+    if (!out) {
+        std::cerr << "Não foi possível gravar a sessão em " << fileName << std::endl;
+        return false;
+    }
+    const SimConfig& config = session.config;
+    out << "# Sessão gravada com --record; reproduza com --replay" << std::endl;
+    out << std::setprecision(9);
+    out << "resolucao " << session.width << "x" << session.height << std::endl;
+    out << "semente " << session.seed << std::endl;
+    out << "labirinto " << config.mazeMode << std::endl;
+    out << "celula " << config.mazeCellSize << std::endl;
+    out << "multidao " << config.crowdSeparation << std::endl;
+    out << "espacamento " << config.crowdSpacing << std::endl;
+    out << "lod " << config.pathLod << std::endl;
+    out << "tipos " << (config.enemyKind == NO_ENEMY_KIND ? "mixed" : enemyKinds[config.enemyKind].key) << std::endl;
+    out << "curva " << (session.shape.curved ? "catmull-rom" : "polilinha") << std::endl;
+    for (const Point& point : session.shape.controlPoints) out << "ponto " << point.x << " " << point.y << std::endl;
+    for (const SessionAction& action : session.actions) {
+        out << "acao " << action.tick << " " << sessionActionNames[action.kind];
+        if (action.kind == SESSION_PLACE_TOWER) out << " " << towerTypes[action.type].key << " " << action.x << " " << action.y;
+        if (action.kind == SESSION_RESIZE) out << " " << (int)action.x << " " << (int)action.y;
+        out << std::endl;
+    }
+    if (session.ticks >= 0) {
+        out << "fim " << session.ticks << " dinheiro " << session.money << " vidas " << session.lives << " onda "
+            << session.wave << " inimigos " << session.enemies << std::endl;
+    }
+    return true;
+}
 
-// Função para compilar shader
-unsigned int compileShader(unsigned int type, const char* source) {
-    unsigned int shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, NULL);
-    glCompileShader(shader);
-    
-    int success;
-    char infoLog[512];
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(shader, 512, NULL, infoLog);
-        std::cout << "Erro de compilação do shader: " << infoLog << std::endl;
+// Na saída do jogo: fecha a gravação com o estado final
+void saveSessionRecording() {
+    SessionRecorder& recorder = sessionRecorder;
+    if (!recorder.active) return;
+    recorder.session.ticks = simulationTick - recorder.startTick;
+    recorder.session.money = money;
+    recorder.session.lives = lives;
+    recorder.session.wave = currentWave;
+    recorder.session.enemies = enemyCount();
+    if (saveSession(recorder.fileName, recorder.session)) {
+        std::cout << "Sessão: " << recorder.session.actions.size() << " ações em " << recorder.session.ticks << " ticks gravadas em "
+                  << recorder.fileName << std::endl;
     }
-    
-    return shader;
 }
 
-// Função para criar programa de shader
-unsigned int createAndLinkShaderProgram(const char* vsSource, const char* fsSource) {
-    unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vsSource);
-    unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fsSource);
-    
-    unsigned int program = glCreateProgram();
-    glAttachShader(program, vertexShader);
-    glAttachShader(program, fragmentShader);
-    glLinkProgram(program);
-    
-    int success;
-    char infoLog[512];
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(program, 512, NULL, infoLog);
-        std::cout << "Erro de linkagem do programa: " << infoLog << std::endl;
+bool parseResolution(const std::string& text, int& width, int& height);
+
+bool loadSession(const std::string& fileName, Session& session) {
+    std::ifstream in(fileName);
+    if (!in) {
+        std::cerr << "Não foi possível abrir a sessão: " << fileName << std::endl;
+        return false;
     }
-    
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-    return program;
+    session = Session();
+    session.shape.controlPoints.clear();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string key;
+        fields >> key;
+        bool ok = true;
+        if (key == "resolucao") {
+            std::string value;
+            ok = (fields >> value) && parseResolution(value.c_str(), session.width, session.height);
+        } else if (key == "semente") {
+            ok = (bool)(fields >> session.seed);
+        } else if (key == "labirinto") {
+            ok = (bool)(fields >> session.config.mazeMode);
+        } else if (key == "celula") {
+            ok = (bool)(fields >> session.config.mazeCellSize);
+        } else if (key == "multidao") {
+            ok = (bool)(fields >> session.config.crowdSeparation);
+        } else if (key == "espacamento") {
+            ok = (bool)(fields >> session.config.crowdSpacing);
+        } else if (key == "lod") {
+            ok = (bool)(fields >> session.config.pathLod);
+        } else if (key == "tipos") {
+            std::string kind;
+            ok = (bool)(fields >> kind);
+            session.config.enemyKind = kind == "mixed" ? NO_ENEMY_KIND : findEnemyKind(kind);
+            ok = ok && (kind == "mixed" || session.config.enemyKind != NO_ENEMY_KIND);
+        } else if (key == "curva") {
+            std::string kind;
+            ok = (bool)(fields >> kind);
+            session.shape.curved = kind == "catmull-rom";
+        } else if (key == "ponto") {
+            Point point;
+            ok = (bool)(fields >> point.x >> point.y);
+            session.shape.controlPoints.push_back(point);
+        } else if (key == "acao") {
+            SessionAction action = {0, SESSION_ACTION_COUNT, 0, 0.0f, 0.0f};
+            std::string name;
+            ok = (bool)(fields >> action.tick >> name);
+            for (int kind = 0; kind < SESSION_ACTION_COUNT; kind++) {
+                if (name == sessionActionNames[kind]) action.kind = (SessionActionKind)kind;
+            }
+            if (action.kind == SESSION_PLACE_TOWER) {
+                std::string type;
+                ok = ok && (fields >> type >> action.x >> action.y);
+                action.type = findTowerType(type);
+                ok = ok && action.type != NO_TOWER_TYPE;
+            } else if (action.kind == SESSION_RESIZE) {
+                ok = ok && (fields >> action.x >> action.y);
+            }
+            ok = ok && action.kind != SESSION_ACTION_COUNT;
+            session.actions.push_back(action);
+        } else if (key == "fim") {
+            std::string label;
+            ok = (bool)(fields >> session.ticks >> label >> session.money >> label >> session.lives >> label >> session.wave
+                        >> label >> session.enemies);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << fileName << ":" << lineNumber << ": linha inválida: " << line << std::endl;
+            return false;
+        }
+    }
+    if (session.shape.controlPoints.size() < 2) session.shape = pathShape;
+    return true;
 }
 
-// Adicione esta constante antes da função initTextRendering
-const std::string EXTENDED_CHARS = "áàâãéèêíìîóòôõúùûçÁÀÂÃÉÈÊÍÌÎÓÒÔÕÚÙÛÇ";
+// ===================== Quadros em voo e latência de apresentação =====================
 
-// Modificar a função initTextRendering para criar o shader program e VAO/VBO
-void initTextRendering() {
-    // Inicializar FreeType
-    if (FT_Init_FreeType(&ft)) {
-        std::cout << "ERRO::FREETYPE: Não foi possível inicializar a biblioteca FreeType" << std::endl;
-        return;
+// Sem limite, o driver enfileira vários swaps e o que aparece na tela fica frames atrás da entrada.
+// Uma fence por frame limita os quadros em voo (--frames-in-flight; 0 = o driver decide): antes de ler
+// a entrada do próximo frame, a CPU espera a GPU terminar o frame de "limite" quadros atrás
+const int MAX_FRAMES_IN_FLIGHT = 8;
+
+struct FramePacer {
+    int limit = 2;
+    GLsync fences[MAX_FRAMES_IN_FLIGHT] = {};
+    int next = 0;
+};
+
+FramePacer framePacer;
+
+void waitForFrameSlot() {
+    PROFILE_ZONE("waitForFrameSlot");
+    if (framePacer.limit <= 0) return;
+    GLsync& fence = framePacer.fences[framePacer.next];
+    if (!fence) return;
+    glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000); // Até 100 ms: nunca trava o jogo
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+// Depois do swap: marca o fim do frame na fila da GPU
+void fenceFrame() {
+    if (framePacer.limit <= 0) return;
+    framePacer.fences[framePacer.next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    framePacer.next = (framePacer.next + 1) % framePacer.limit;
+}
+
+void releaseFrameFences() {
+    for (GLsync& fence : framePacer.fences) {
+        if (fence) glDeleteSync(fence);
+        fence = nullptr;
     }
+}
 
-    // Tentar carregar a fonte do caminho específico primeiro
-    if (FT_New_Face(ft, FONT_PATH, 0, &face)) {
-        // Se falhar, tentar uma fonte do Windows como fallback
-        std::cout << "AVISO: Não foi possível carregar " << FONT_PATH << ", tentando fonte do sistema..." << std::endl;
-        if (FT_New_Face(ft, "C:/Windows/Fonts/arial.ttf", 0, &face)) {
-            std::cout << "ERRO::FREETYPE: Falha ao carregar qualquer fonte" << std::endl;
-            return;
+// --input-latency: cada evento de entrada recebe um instante, e o primeiro swap que o reflete fecha a
+// medição. Comandos são refletidos no frame do tick que os aplicou; movimentos do cursor, no frame cujo
+// preview de posicionamento leu o cursor depois deles; teclas de interface, no frame seguinte
+enum InputEventKind {
+    INPUT_EVENT_COMMAND,
+    INPUT_EVENT_CURSOR,
+    INPUT_EVENT_INTERFACE,
+    INPUT_EVENT_KIND_COUNT
+};
+
+const char* const inputEventNames[INPUT_EVENT_KIND_COUNT] = {"comandos", "cursor", "interface"};
+
+struct InputLatencyProbe {
+    bool enabled = false;
+    std::vector<std::chrono::steady_clock::time_point> pendingCursor;
+    std::vector<std::chrono::steady_clock::time_point> latched[INPUT_EVENT_KIND_COUNT];
+    TimingSamples toPresent[INPUT_EVENT_KIND_COUNT];
+};
+
+InputLatencyProbe inputLatency;
+
+void latchInputEvent(InputEventKind kind, std::chrono::steady_clock::time_point issuedAt) {
+    if (inputLatency.enabled) inputLatency.latched[kind].push_back(issuedAt);
+}
+
+void cursorPositionCallback(GLFWwindow*, double, double) {
+    if (inputLatency.enabled) inputLatency.pendingCursor.push_back(std::chrono::steady_clock::now());
+}
+
+// Chamada pelo preview no momento em que lê o cursor; sem preview, o movimento não aparece em lugar nenhum
+void latchCursorEvents(bool reflected) {
+    if (!inputLatency.enabled) return;
+    std::vector<std::chrono::steady_clock::time_point>& latched = inputLatency.latched[INPUT_EVENT_CURSOR];
+    if (reflected) latched.insert(latched.end(), inputLatency.pendingCursor.begin(), inputLatency.pendingCursor.end());
+    inputLatency.pendingCursor.clear();
+}
+
+// Logo depois do swap: tudo o que foi travado neste frame chegou à apresentação
+void recordInputPresent() {
+    if (!inputLatency.enabled) return;
+    auto now = std::chrono::steady_clock::now();
+    for (int kind = 0; kind < INPUT_EVENT_KIND_COUNT; kind++) {
+        for (const auto& issuedAt : inputLatency.latched[kind]) {
+            inputLatency.toPresent[kind].add(std::chrono::duration<double, std::milli>(now - issuedAt).count());
         }
+        inputLatency.latched[kind].clear();
     }
+}
 
-    // Definir tamanho da fonte
-    FT_Set_Pixel_Sizes(face, 0, FONT_PIXEL_HEIGHT_LOAD);
-    
-    // Ativar suporte a Unicode
-    FT_Select_Charmap(face, FT_ENCODING_UNICODE);
+void printInputPresentReport() {
+    if (!inputLatency.enabled) return;
+    std::cout << "=== Latência entrada→apresentação (quadros em voo: ";
+    if (framePacer.limit > 0) std::cout << framePacer.limit;
+    else std::cout << "sem limite";
+    std::cout << ") ===" << std::endl;
+    for (int kind = 0; kind < INPUT_EVENT_KIND_COUNT; kind++) {
+        const TimingSamples& latency = inputLatency.toPresent[kind];
+        if (latency.samples.empty()) continue;
+        std::string name = std::string(inputEventNames[kind]) + " (" + std::to_string(latency.samples.size()) + ")";
+        latency.print(name.c_str());
+    }
+}
 
-    // Configurar OpenGL
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+// ===================== Fila de comandos de entrada =====================
 
-    // Gerar texturas para os primeiros 128 caracteres ASCII
-    for (int c = 0; c < 128; c++) {
-        // Carregar caractere
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
-            std::cout << "ERRO::FREETYPE: Falha ao carregar glifo " << c << std::endl;
-            continue;
-        }
+// Os callbacks do GLFW não mexem na simulação: empilham comandos que o loop principal aplica na
+// fronteira do tick, antes de update(), na ordem em que chegaram. Cada comando leva o tick da simulação
+// e o instante em que foi emitido; ao fim do update() que o aplicou, o tempo desde a emissão entra na
+// latência entrada→efeito do seu tipo. O mutex deixa a fila pronta para a simulação em outra thread
+struct InputCommand {
+    SessionActionKind kind;
+    int type;
+    float x, y;
+    long long issuedTick;
+    std::chrono::steady_clock::time_point issuedAt;
+};
 
-        // Gerar textura
-        unsigned int texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            0,
-            GL_RED,
-            GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer
-        );
+struct InputCommandQueue {
+    std::mutex mutex;
+    std::vector<InputCommand> pending;  // Emitidos pelos callbacks
+    std::vector<InputCommand> applied;  // Aplicados neste tick, aguardando o fim do update()
+    TimingSamples latency[SESSION_ACTION_COUNT];
+    long long maxTickDelay = 0;         // Maior atraso entre emissão e aplicação, em ticks
 
-        // Definir opções de textura
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    InputCommandQueue() {
+        pending.reserve(64);
+        applied.reserve(64);
+    }
+};
 
-        // Armazenar caractere para uso posterior
-        Character character = {
-            texture,
-            Point(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-            Point(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            (unsigned int)face->glyph->advance.x
-        };
-        Characters.insert(std::pair<int, Character>(c, character));
+InputCommandQueue inputCommands;
+
+void enqueueInputCommand(SessionActionKind kind, int type = 0, float x = 0.0f, float y = 0.0f) {
+    std::lock_guard<std::mutex> lock(inputCommands.mutex);
+    std::vector<InputCommand>& pending = inputCommands.pending;
+    // Arrastar a borda da janela gera um evento por pixel: só o último tamanho importa
+    if (kind == SESSION_RESIZE && !pending.empty() && pending.back().kind == SESSION_RESIZE) {
+        pending.back().x = x;
+        pending.back().y = y;
+        return;
     }
+    pending.push_back({kind, type, x, y, simulationTick, std::chrono::steady_clock::now()});
+}
 
-    // Lista de caracteres especiais para pré-carregar
-    const wchar_t specialChars[] = L"áàâãéèêíìîóòôõúùûçÁÀÂÃÉÈÊÍÌÎÓÒÔÕÚÙÛÇ";
-    
-    // Adicionar caracteres especiais do português
-    for (int i = 0; specialChars[i] != L'\0'; i++) {
-        wchar_t c = specialChars[i];
-        
-        // Carregar caractere
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
-            std::cout << "ERRO::FREETYPE: Falha ao carregar glifo especial " << (int)c << std::endl;
-            continue;
+// Fronteira do tick: aplica (e grava, com --record) o que chegou desde o tick anterior
+void applyInputCommands() {
+    PROFILE_ZONE("applyInputCommands");
+    {
+        std::lock_guard<std::mutex> lock(inputCommands.mutex);
+        inputCommands.applied.clear();
+        inputCommands.applied.swap(inputCommands.pending);
+    }
+    for (const InputCommand& command : inputCommands.applied) {
+        performSessionAction(command.kind, command.type, command.x, command.y);
+    }
+}
+
+// Depois do update() do tick: o efeito dos comandos aplicados já está no estado da simulação
+void finishInputCommands() {
+    if (inputCommands.applied.empty()) return;
+    auto now = std::chrono::steady_clock::now();
+    for (const InputCommand& command : inputCommands.applied) {
+        inputCommands.latency[command.kind].add(std::chrono::duration<double, std::milli>(now - command.issuedAt).count());
+        inputCommands.maxTickDelay = std::max(inputCommands.maxTickDelay, simulationTick - command.issuedTick);
+        latchInputEvent(INPUT_EVENT_COMMAND, command.issuedAt);
+    }
+    inputCommands.applied.clear();
+}
+
+void printInputLatencyReport() {
+    bool header = false;
+    for (int kind = 0; kind < SESSION_ACTION_COUNT; kind++) {
+        const TimingSamples& latency = inputCommands.latency[kind];
+        if (latency.samples.empty()) continue;
+        if (!header) {
+            std::cout << "=== Latência entrada→efeito (atraso máximo " << inputCommands.maxTickDelay << " ticks) ===" << std::endl;
+            header = true;
         }
+        std::string name = std::string(sessionActionNames[kind]) + " (" + std::to_string(latency.samples.size()) + ")";
+        latency.print(name.c_str());
+    }
+}
 
-        // Gerar textura
-        unsigned int texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            0,
-            GL_RED,
-            GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer
-        );
+// Callbacks do GLFW
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+    glViewport(0, 0, width, height);
+    enqueueInputCommand(SESSION_RESIZE, 0, (float)width, (float)height);
+}
 
-        // Definir opções de textura
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS && placingTowerType != NO_TOWER_TYPE) {
+        double mouseX, mouseY;
+        glfwGetCursorPos(window, &mouseX, &mouseY);
+        mouseY = WINDOW_HEIGHT - mouseY; // Inverter Y
+        enqueueInputCommand(SESSION_PLACE_TOWER, placingTowerType, (float)mouseX, (float)mouseY);
+    }
+}
 
-        // Armazenar caractere para uso posterior usando o valor Unicode como chave
-        Character character = {
-            texture,
-            Point(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-            Point(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            (unsigned int)face->glyph->advance.x
-        };
-        Characters.insert(std::pair<int, Character>((int)c, character));
+void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    if (action == GLFW_PRESS) {
+        switch (key) {
+            case GLFW_KEY_1:
+                selectTowerType(TOWER_BASIC);
+                latchInputEvent(INPUT_EVENT_INTERFACE, std::chrono::steady_clock::now());
+                break;
+            case GLFW_KEY_2:
+                selectTowerType(TOWER_ADVANCED);
+                latchInputEvent(INPUT_EVENT_INTERFACE, std::chrono::steady_clock::now());
+                break;
+            case GLFW_KEY_3:
+                selectTowerType(TOWER_FROST);
+                latchInputEvent(INPUT_EVENT_INTERFACE, std::chrono::steady_clock::now());
+                break;
+            case GLFW_KEY_4:
+                selectTowerType(TOWER_FIRE);
+                latchInputEvent(INPUT_EVENT_INTERFACE, std::chrono::steady_clock::now());
+                break;
+            case GLFW_KEY_SPACE:
+                enqueueInputCommand(SESSION_START_WAVE);
+                break;
+            case GLFW_KEY_R:
+                if (gameOver) enqueueInputCommand(SESSION_RESTART);
+                break;
+            case GLFW_KEY_BACKSPACE:
+                enqueueInputCommand(SESSION_REWIND);
+                break;
+            case GLFW_KEY_M:
+                enqueueInputCommand(SESSION_TOGGLE_MAZE);
+                break;
+            case GLFW_KEY_C:
+                enqueueInputCommand(SESSION_TOGGLE_CROWD);
+                break;
+            case GLFW_KEY_P:
+                if (profiler.enabled) {
+                    size_t events = writeProfilerTrace();
+                    showFeedback("Perfil salvo em " + profiler.fileName + " (" + std::to_string(events) + " eventos)");
+                } else {
+                    showFeedback("Profiler desligado (use --profile)");
+                }
+                break;
+            case GLFW_KEY_F3:
+                togglePerfHud();
+                break;
+            case GLFW_KEY_ESCAPE:
+                placingTowerType = NO_TOWER_TYPE;
+                showFeedback("Seleção de torre cancelada");
+                latchInputEvent(INPUT_EVENT_INTERFACE, std::chrono::steady_clock::now());
+                break;
+        }
+    }
+}
+
+// ===================== Avaliador headless de layouts (Monte Carlo) =====================
+
+// Torre de um layout candidato: tipo (TowerTypeId) e posição normalizada (0.0-1.0)
+struct LayoutTower {
+    int type;
+    Point normalizedPos;
+};
+
+// Layout candidato: as torres são construídas na ordem da lista, assim que houver dinheiro
+struct Layout {
+    std::string name;
+    std::vector<LayoutTower> towers;
+};
+
+// Resultado de uma partida headless completa
+struct GameResult {
+    int livesLeft = 0;
+    int waveReached = 0;
+    bool victory = false;
+    int towersBuilt = 0;
+    long long ticks = 0;
+    std::vector<float> moneyPerWave; // Dinheiro no início de cada onda
+    float finalMoney = 0.0f;
+};
+
+// Configuração do avaliador (preenchida pela linha de comando)
+struct EvaluatorOptions {
+    std::string layoutFile;
+    int seeds = 32;
+    unsigned int baseSeed = 1;
+    int threads = 0;          // 0 = todos os núcleos
+    int searchIterations = 0; // 0 = apenas avaliar
+    int searchRestarts = 0;
+    float spawnJitter = 0.25f;    // Variação do intervalo entre lotes: é o que faz cada semente jogar uma partida diferente
+    double minTicksPerSecond = 0; // Piso de vazão em milhões de ticks/s (0 = sem checagem); abaixo dele sai com código 1
+};
+
+const long long HEADLESS_MAX_TICKS_PER_WAVE = 2000000; // Proteção contra ondas que nunca terminam
+
+// Lê layouts de um arquivo texto:
+//   layout <nome>
+//   <tipo> <x normalizado> <y normalizado>
+// Linhas vazias e iniciadas por '#' são ignoradas
+bool loadLayouts(const std::string& fileName, std::vector<Layout>& layouts) {
+    std::ifstream file(fileName);
+    if (!file) {
+        std::cerr << "Não foi possível abrir o arquivo de layouts: " << fileName << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream in(line);
+        std::string word;
+        if (!(in >> word) || word[0] == '#') continue;
+
+        if (word == "layout") {
+            Layout layout;
+            std::getline(in >> std::ws, layout.name);
+            if (layout.name.empty()) layout.name = "layout" + std::to_string(layouts.size() + 1);
+            layouts.push_back(layout);
+            continue;
+        }
+
+        LayoutTower tower;
+        tower.type = findTowerType(word);
+        if (!(in >> tower.normalizedPos.x >> tower.normalizedPos.y) || tower.type == NO_TOWER_TYPE) {
+            std::cerr << fileName << ":" << lineNumber << ": torre inválida: " << line << std::endl;
+            return false;
+        }
+        if (layouts.empty()) layouts.push_back({"layout1", {}});
+        layouts.back().towers.push_back(tower);
     }
+    return true;
+}
 
-    // Criar o shader program para texto
-    textShaderProgram = createAndLinkShaderProgram(textVertexShaderSource, textFragmentShaderSource);
-    
-    // Configurar o VAO e VBO para o texto
-    glGenVertexArrays(1, &textVAO);
-    glGenBuffers(1, &textVBO);
-    glBindVertexArray(textVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+// Lê a forma do caminho de um arquivo texto:
+//   curva <catmull-rom|polilinha>   (padrão: polilinha)
+//   <x normalizado> <y normalizado>  (um ponto de controle por linha, da entrada à saída)
+// Linhas vazias e iniciadas por '#' são ignoradas
+bool loadPathShape(const std::string& fileName, PathShape& shape) {
+    std::ifstream file(fileName);
+    if (!file) {
+        std::cerr << "Não foi possível abrir o arquivo de caminho: " << fileName << std::endl;
+        return false;
+    }
+
+    PathShape loaded;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream in(line);
+        std::string word;
+        if (!(in >> word) || word[0] == '#') continue;
+
+        if (word == "curva") {
+            std::string kind;
+            in >> kind;
+            if (kind != "catmull-rom" && kind != "polilinha") {
+                std::cerr << fileName << ":" << lineNumber << ": curva inválida: " << line << std::endl;
+                return false;
+            }
+            loaded.curved = kind == "catmull-rom";
+            continue;
+        }
+
+        Point point;
+        std::istringstream coordinates(line);
+        if (!(coordinates >> point.x >> point.y)) {
+            std::cerr << fileName << ":" << lineNumber << ": ponto inválido: " << line << std::endl;
+            return false;
+        }
+        loaded.controlPoints.push_back(point);
+    }
+    if (loaded.controlPoints.size() < 2) {
+        std::cerr << fileName << ": o caminho precisa de pelo menos dois pontos" << std::endl;
+        return false;
+    }
+    shape = loaded;
+    return true;
 }
 
-// Função auxiliar para obter o próximo ponto de código UTF-8
-int utf8_next(const std::string& str, size_t& pos) {
-    if (pos >= str.length()) return 0;
-    
-    unsigned char c = str[pos++];
-    
-    // ASCII comum (0-127)
-    if (c < 128) return c;
-    
-    // Obter o número de bytes adicionais
-    int extra = 0;
-    if ((c & 0xE0) == 0xC0) extra = 1;      // 110xxxxx
-    else if ((c & 0xF0) == 0xE0) extra = 2; // 1110xxxx
-    else if ((c & 0xF8) == 0xF0) extra = 3; // 11110xxx
-    else return '?';  // Formato inválido
-    
-    // Calcular o ponto de código
-    int codepoint = (c & (0x3F >> extra));
-    
-    // Ler bytes adicionais
-    for (int i = 0; i < extra && pos < str.length(); i++) {
-        c = str[pos++];
-        if ((c & 0xC0) != 0x80) return '?'; // Formato inválido
-        codepoint = (codepoint << 6) | (c & 0x3F);
+// Coloca as próximas torres do layout enquanto houver dinheiro, respeitando a ordem de construção.
+// Torres em posição inválida (canPlaceTower) são descartadas
+void buildAffordableTowers(const Layout& layout, size_t& nextTower, GameResult& result) {
+    while (nextTower < layout.towers.size()) {
+        const LayoutTower& lt = layout.towers[nextTower];
+        if (money < towerTypes[lt.type].cost) return;
+
+        float x = lt.normalizedPos.x * WINDOW_WIDTH;
+        float y = lt.normalizedPos.y * WINDOW_HEIGHT;
+        if (canPlaceTower(x, y)) {
+            addTower(x, y, lt.type);
+            money -= towerTypes[lt.type].cost;
+            result.towersBuilt++;
+        }
+        nextTower++;
     }
-    
-    return codepoint;
 }
 
-// Substituir a função RenderText com a implementação correta para Unicode
-void RenderText(const std::string& text, float x, float y_baseline, float scale, Color color) {
-    // Ativar o shader correspondente
-    glUseProgram(textShaderProgram);
-    setProjectionMatrix(textShaderProgram);
-    
-    glUniform3f(glGetUniformLocation(textShaderProgram, "textColor"), color.r, color.g, color.b);
-    glActiveTexture(GL_TEXTURE0);
-    glUniform1i(glGetUniformLocation(textShaderProgram, "textSampler"), 0);
-    glBindVertexArray(textVAO);
+// Joga uma partida completa sem janela usando a progressão de ondas normal do jogo.
+// Usa o estado thread_local da thread que chama
+GameResult runHeadlessGame(const Layout& layout, unsigned int seed) {
+    PROFILE_ZONE("runHeadlessGame");
+    GameResult result;
+    initGame();
+    simulationSeed = seed;
+
+    size_t nextTower = 0;
+    while (!gameOver) {
+        buildAffordableTowers(layout, nextTower, result);
+        result.moneyPerWave.push_back(money);
+        startWave();
+
+        long long waveTicks = 0;
+        while (waveInProgress && !gameOver && waveTicks < HEADLESS_MAX_TICKS_PER_WAVE) {
+            waveTicks += skipIdleTicks(frameCount + (HEADLESS_MAX_TICKS_PER_WAVE - waveTicks));
+            if (waveTicks >= HEADLESS_MAX_TICKS_PER_WAVE) break;
+            update();
+            waveTicks++;
+        }
+        result.ticks += waveTicks;
+        if (waveInProgress) break; // Onda travada: conta como derrota
+    }
 
-    // Percorrer a string usando a função auxiliar para caracteres UTF-8
-    size_t pos = 0;
-    while (pos < text.length()) {
-        int codepoint = utf8_next(text, pos);
-        if (codepoint == 0) break;
+    result.livesLeft = std::max(lives, 0);
+    result.waveReached = currentWave;
+    result.victory = lives > 0 && !waveInProgress && currentWave >= simConfig.maxWaves;
+    result.finalMoney = money;
+    return result;
+}
 
-        // Verificar se temos este caractere carregado
-        if (Characters.find(codepoint) == Characters.end()) {
-            x += (Characters['?'].Advance >> 6) * scale; // Corrigido: primeiro faz o shift, depois multiplica
-            continue;
+// Executa fn(i) para i em [0, count) distribuindo o trabalho entre as threads
+template <typename Fn>
+void parallelFor(int count, int threadCount, Fn fn) {
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (int i = next++; i < count; i = next++) {
+            fn(i);
         }
+    };
 
-        Character ch = Characters[codepoint];
+    threadCount = std::max(1, std::min(threadCount, count));
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threadCount; t++) {
+        pool.emplace_back([&worker, t]() {
+            profilerThread = (uint32_t)t;
+            worker();
+        });
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
 
-        float xpos = x + ch.Bearing.x * scale;
-        float ypos = y_baseline - (ch.Size.y - ch.Bearing.y) * scale;
+// Estatísticas agregadas de um layout sobre todas as sementes
+struct LayoutStats {
+    float meanLives = 0, minLives = 0, maxLives = 0;
+    float meanWave = 0;
+    float victoryRate = 0;
+    float meanTowersBuilt = 0;
+    float meanFinalMoney = 0;
+    std::vector<float> meanMoneyPerWave;
+    long long totalTicks = 0;
+
+    // Pontuação usada pela busca: onda alcançada pesa mais que vidas, que pesam mais que dinheiro
+    float score() const { return meanWave * 10000.0f + meanLives * 500.0f + meanFinalMoney; }
+};
 
-        float w = ch.Size.x * scale;
-        float h = ch.Size.y * scale;
-        
-        // Atualizar VBO para cada caractere
-        float vertices[6][4] = {
-            { xpos,     ypos + h,   0.0f, 0.0f },            
-            { xpos,     ypos,       0.0f, 1.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
+LayoutStats evaluateLayout(const Layout& layout, const EvaluatorOptions& options) {
+    std::vector<GameResult> results(options.seeds);
+    parallelFor(options.seeds, options.threads, [&](int i) {
+        results[i] = runHeadlessGame(layout, options.baseSeed + i);
+    });
+
+    LayoutStats stats;
+    stats.minLives = INFINITY;
+    stats.maxLives = -INFINITY;
+    stats.meanMoneyPerWave.assign(simConfig.maxWaves, 0.0f);
+    std::vector<int> moneySamples(simConfig.maxWaves, 0);
+    for (const auto& r : results) {
+        stats.meanLives += r.livesLeft;
+        stats.minLives = std::min(stats.minLives, (float)r.livesLeft);
+        stats.maxLives = std::max(stats.maxLives, (float)r.livesLeft);
+        stats.meanWave += r.waveReached;
+        stats.victoryRate += r.victory ? 1.0f : 0.0f;
+        stats.meanTowersBuilt += r.towersBuilt;
+        stats.meanFinalMoney += r.finalMoney;
+        stats.totalTicks += r.ticks;
+        for (size_t w = 0; w < r.moneyPerWave.size() && w < stats.meanMoneyPerWave.size(); w++) {
+            stats.meanMoneyPerWave[w] += r.moneyPerWave[w];
+            moneySamples[w]++;
+        }
+    }
 
-            { xpos,     ypos + h,   0.0f, 0.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
-            { xpos + w, ypos + h,   1.0f, 0.0f }           
-        };
-        
-        // Renderizar a textura do glifo sobre o quad
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-        
-        // Atualizar conteúdo do VBO
-        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        
-        // Renderizar quad
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        
-        // Avançar para o próximo glifo
-        x += (ch.Advance >> 6) * scale; // Corrigido: primeiro faz o shift, depois multiplica
+    float n = (float)results.size();
+    stats.meanLives /= n;
+    stats.meanWave /= n;
+    stats.victoryRate /= n;
+    stats.meanTowersBuilt /= n;
+    stats.meanFinalMoney /= n;
+    for (size_t w = 0; w < stats.meanMoneyPerWave.size(); w++) {
+        if (moneySamples[w] > 0) stats.meanMoneyPerWave[w] /= moneySamples[w];
     }
-    
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // Ondas que nenhuma partida alcançou não entram na curva
+    while (!stats.meanMoneyPerWave.empty() && moneySamples[stats.meanMoneyPerWave.size() - 1] == 0) {
+        stats.meanMoneyPerWave.pop_back();
+    }
+    return stats;
 }
 
-// Funções de renderização OpenGL modernas
-void setProjectionMatrix(unsigned int currentShaderProgram) { // Aceita o shader program
-    glUseProgram(currentShaderProgram);
-    
-    // Matriz de projeção ortográfica
-    float left = 0.0f, right = (float)WINDOW_WIDTH;
-    float bottom = 0.0f, top = (float)WINDOW_HEIGHT;
-    float near = -1.0f, far = 1.0f;
-    
-    float projection[16] = {
-        2.0f / (right - left), 0.0f, 0.0f, 0.0f,
-        0.0f, 2.0f / (top - bottom), 0.0f, 0.0f,
-        0.0f, 0.0f, -2.0f / (far - near), 0.0f,
-        -(right + left) / (right - left), -(top + bottom) / (top - bottom), -(far + near) / (far - near), 1.0f
-    };
-    
-    int projLoc = glGetUniformLocation(currentShaderProgram, "projection");
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, projection);
+void printLayoutStats(const Layout& layout, const LayoutStats& stats) {
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "[" << layout.name << "] torres: " << stats.meanTowersBuilt << "/" << layout.towers.size()
+              << " | vidas: " << stats.meanLives << " (min " << stats.minLives << ", max " << stats.maxLives << ")"
+              << " | onda: " << stats.meanWave
+              << " | vitórias: " << stats.victoryRate * 100.0f << "%"
+              << " | dinheiro final: " << stats.meanFinalMoney << std::endl;
+    std::cout << "    dinheiro por onda:";
+    for (float m : stats.meanMoneyPerWave) std::cout << " " << std::setprecision(0) << m;
+    std::cout << std::setprecision(2) << std::endl;
 }
 
-void drawCircle(float x, float y, float radius, Color color) {
-    const int segments = 32;
-    std::vector<float> vertices;
-    
-    // Centro
-    vertices.push_back(x);
-    vertices.push_back(y);
-    
-    // Pontos do círculo
-    for (int i = 0; i <= segments; i++) {
-        float angle = 2.0f * (float)M_PI * i / segments;
-        vertices.push_back(x + cos(angle) * radius);
-        vertices.push_back(y + sin(angle) * radius);
+void printLayout(const Layout& layout) {
+    std::cout << "layout " << layout.name << std::endl;
+    std::cout << std::setprecision(4);
+    for (const auto& t : layout.towers) {
+        std::cout << towerTypes[t.type].key << " " << t.normalizedPos.x << " " << t.normalizedPos.y << std::endl;
     }
-    
-    glUseProgram(shaderProgram); // Usar shader de formas
-    setProjectionMatrix(shaderProgram); // Passar o shader program
-    
-    int colorLoc = glGetUniformLocation(shaderProgram, "color");
-    glUniform4f(colorLoc, color.r, color.g, color.b, color.a);
-    
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
-    
-    glDrawArrays(GL_TRIANGLE_FAN, 0, vertices.size() / 2);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    std::cout << std::setprecision(2);
 }
 
-// Nova função para desenhar hexágono
-void drawHexagon(float x, float y, float radius, Color color) {
-    const int segments = 6; // Um hexágono tem 6 lados
-    std::vector<float> vertices;
+// Verifica se todas as torres do layout passam em canPlaceTower quando colocadas em ordem
+bool isLayoutPlaceable(const Layout& layout) {
+    towers.clear();
+    rebuildMapGrids();
+    bool placeable = true;
+    for (const auto& t : layout.towers) {
+        float x = t.normalizedPos.x * WINDOW_WIDTH;
+        float y = t.normalizedPos.y * WINDOW_HEIGHT;
+        if (!isPlacementFree(x, y)) {
+            placeable = false;
+            break;
+        }
+        addTower(x, y, t.type);
+    }
+    towers.clear();
+    rebuildMapGrids();
+    rebuildSimTimers();
+    return placeable;
+}
 
-    // Centro (para TRIANGLE_FAN)
-    vertices.push_back(x);
-    vertices.push_back(y);
+// Sorteia uma posição válida para a torre i (as demais torres ficam onde estão)
+bool randomizeTowerPosition(Layout& layout, size_t i, std::mt19937& searchRng, float jitter) {
+    std::uniform_real_distribution<float> uniform(0.03f, 0.97f);
+    std::normal_distribution<float> normal(0.0f, jitter);
+    Point original = layout.towers[i].normalizedPos;
+
+    for (int attempt = 0; attempt < 64; attempt++) {
+        Point& p = layout.towers[i].normalizedPos;
+        if (jitter > 0.0f) {
+            p.x = std::min(0.97f, std::max(0.03f, original.x + normal(searchRng)));
+            p.y = std::min(0.97f, std::max(0.03f, original.y + normal(searchRng)));
+        } else {
+            p.x = uniform(searchRng);
+            p.y = uniform(searchRng);
+        }
+        if (isLayoutPlaceable(layout)) return true;
+    }
+    layout.towers[i].normalizedPos = original;
+    return false;
+}
 
-    // Pontos do hexágono
-    for (int i = 0; i <= segments; i++) { // <= para fechar o hexágono
-        // ROTAÇÃO: Adiciona π/6 radianos (30°) para alinhar a base
-        float angle = 2.0f * (float)M_PI * i / segments + (M_PI / 6.0f); // Adiciona rotação para alinhar a base
-        vertices.push_back(x + cos(angle) * radius);
-        vertices.push_back(y + sin(angle) * radius);
+// Hill climbing com reinícios aleatórios sobre as posições das torres (os tipos e a ordem são mantidos)
+Layout searchLayout(const Layout& start, const EvaluatorOptions& options) {
+    std::mt19937 searchRng(options.baseSeed * 7919u + 17u);
+    Layout best = start;
+    LayoutStats bestStats = evaluateLayout(best, options);
+
+    for (int restart = 0; restart <= options.searchRestarts; restart++) {
+        Layout current = start;
+        if (restart > 0) {
+            for (size_t i = 0; i < current.towers.size(); i++) {
+                randomizeTowerPosition(current, i, searchRng, 0.0f);
+            }
+        }
+        LayoutStats currentStats = evaluateLayout(current, options);
+
+        for (int iter = 0; iter < options.searchIterations && !current.towers.empty(); iter++) {
+            Layout candidate = current;
+            size_t i = searchRng() % candidate.towers.size();
+            // Na maioria das vezes um passo local, às vezes um salto para qualquer lugar do mapa
+            float jitter = (searchRng() % 4 == 0) ? 0.0f : 0.05f;
+            if (!randomizeTowerPosition(candidate, i, searchRng, jitter)) continue;
+
+            LayoutStats candidateStats = evaluateLayout(candidate, options);
+            if (candidateStats.score() > currentStats.score()) {
+                current = candidate;
+                currentStats = candidateStats;
+            }
+        }
+
+        std::cout << "Reinício " << restart << ": pontuação " << currentStats.score() << std::endl;
+        if (currentStats.score() > bestStats.score()) {
+            best = current;
+            bestStats = currentStats;
+        }
     }
 
-    glUseProgram(shaderProgram);
-    setProjectionMatrix(shaderProgram);
+    best.name = start.name + "-otimizado";
+    return best;
+}
 
-    int colorLoc = glGetUniformLocation(shaderProgram, "color");
-    glUniform4f(colorLoc, color.r, color.g, color.b, color.a);
+int runEvaluator(const EvaluatorOptions& options) {
+    std::vector<Layout> layouts;
+    if (!loadLayouts(options.layoutFile, layouts)) return 1;
+    if (layouts.empty()) {
+        std::cerr << "Nenhum layout encontrado em " << options.layoutFile << std::endl;
+        return 1;
+    }
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
+    updatePath();
+    int threads = options.threads > 0 ? options.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+    EvaluatorOptions opts = options;
+    opts.threads = threads;
+    simConfig.spawnJitter = opts.spawnJitter;
+
+    std::cout << "=== Avaliador de layouts ===" << std::endl;
+    std::cout << "Resolução: " << WINDOW_WIDTH << "x" << WINDOW_HEIGHT << " | sementes: " << opts.seeds
+              << " | threads: " << threads << " | variação de spawn: ±" << opts.spawnJitter * 100.0f << "%" << std::endl;
+    if (opts.spawnJitter <= 0.0f && opts.seeds > 1) {
+        std::cout << "Aviso: sem variação de spawn todas as sementes jogam a mesma partida" << std::endl;
+    }
 
-    glDrawArrays(GL_TRIANGLE_FAN, 0, vertices.size() / 2);
+    auto start = std::chrono::steady_clock::now();
+    long long games = 0, ticks = 0;
+    for (const auto& layout : layouts) {
+        if (!isLayoutPlaceable(layout)) {
+            std::cout << "[" << layout.name << "] aviso: há torres em posições inválidas (serão ignoradas)" << std::endl;
+        }
+        LayoutStats stats = evaluateLayout(layout, opts);
+        printLayoutStats(layout, stats);
+        games += opts.seeds;
+        ticks += stats.totalTicks;
+
+        if (opts.searchIterations > 0) {
+            Layout best = searchLayout(layout, opts);
+            LayoutStats bestStats = evaluateLayout(best, opts);
+            printLayoutStats(best, bestStats);
+            printLayout(best);
+            games += (long long)opts.seeds * (opts.searchIterations + 2) * (opts.searchRestarts + 1);
+        }
+    }
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double megaTicksPerSecond = ticks / seconds / 1e6;
+    std::cout << "Tempo: " << seconds << " s | ~" << games / seconds << " partidas/s";
+    if (opts.searchIterations == 0) std::cout << " | " << megaTicksPerSecond << " M ticks/s";
+    std::cout << std::endl;
+    saveProfilerTrace();
+
+    // Checagem de regressão de vazão (só na avaliação simples, a busca não conta ticks)
+    if (opts.minTicksPerSecond > 0 && opts.searchIterations == 0 && megaTicksPerSecond < opts.minTicksPerSecond) {
+        std::cout << "FALHA: " << megaTicksPerSecond << " M ticks/s abaixo do piso de " << opts.minTicksPerSecond << " M ticks/s" << std::endl;
+        return 1;
+    }
+    return 0;
 }
 
-void drawRectangle(float x, float y, float width, float height, Color color) {
-    float vertices[] = {
-        x, y,
-        x + width, y,
-        x + width, y + height,
-        x, y + height
-    };
-    
-    glUseProgram(shaderProgram); // Usar shader de formas
-    setProjectionMatrix(shaderProgram); // Passar o shader program
-    
-    int colorLoc = glGetUniformLocation(shaderProgram, "color");
-    glUniform4f(colorLoc, color.r, color.g, color.b, color.a);
-    
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
-    
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+// ===================== Cenários de estresse =====================
+
+// Cenário de estresse: lido de arquivo "chave = valor" e/ou da linha de comando
+struct StressScenario {
+    int enemiesPerWave = 10000;
+    int waves = 1;
+    int spawnDelay = 1;          // Ticks entre spawns
+    int spawnBatch = 100;        // Inimigos por spawn
+    float enemySpeedScale = 10.0f;
+    int towerColumns = 40;
+    int towerRows = 20;
+    int towerType = TOWER_BASIC;
+    float projectileSpeed = 6.0f;
+    int projectileMode = -1;     // -1 = o de cada tipo de torre
+    int enemyKind = ENEMY_NORMAL; // NO_ENEMY_KIND = ondas mistas
+    long long maxTicks = 0;      // 0 = até a última onda terminar
+    bool headless = false;
+};
+
+// Lê "CxL" (ex: 100x100)
+bool parseGrid(const std::string& text, int& columns, int& rows) {
+    char separator = 0;
+    std::istringstream in(text);
+    return (in >> columns >> separator >> rows) && separator == 'x' && columns >= 0 && rows >= 0;
 }
 
-void drawLine(Point start, Point end, Color color, float width = 1.0f) {
-    float vertices[] = {
-        start.x, start.y,
-        end.x, end.y
-    };
-    
-    glUseProgram(shaderProgram); // Usar shader de formas
-    setProjectionMatrix(shaderProgram); // Passar o shader program
-    
-    int colorLoc = glGetUniformLocation(shaderProgram, "color");
-    glUniform4f(colorLoc, color.r, color.g, color.b, color.a);
-    
-    glLineWidth(width);
-    
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
-    
-    glDrawArrays(GL_LINES, 0, 2);
-    
-    glLineWidth(1.0f);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+// Aplica uma opção do cenário; usada tanto pelo arquivo quanto pela linha de comando
+bool setStressOption(StressScenario& scenario, const std::string& key, const std::string& value) {
+    std::istringstream in(value);
+    if (key == "enemies") return (bool)(in >> scenario.enemiesPerWave);
+    if (key == "waves") return (bool)(in >> scenario.waves);
+    if (key == "spawn_delay") return (bool)(in >> scenario.spawnDelay);
+    if (key == "spawn_batch") return (bool)(in >> scenario.spawnBatch);
+    if (key == "enemy_speed") return (bool)(in >> scenario.enemySpeedScale);
+    if (key == "tower_grid") return parseGrid(value, scenario.towerColumns, scenario.towerRows);
+    if (key == "tower_type") {
+        scenario.towerType = findTowerType(value);
+        return scenario.towerType != NO_TOWER_TYPE;
+    }
+    if (key == "projectile_speed") return (bool)(in >> scenario.projectileSpeed);
+    if (key == "projectile_mode") {
+        if (value == "type") scenario.projectileMode = -1;
+        else if (value == "homing") scenario.projectileMode = PROJECTILE_HOMING;
+        else if (value == "ballistic") scenario.projectileMode = PROJECTILE_BALLISTIC;
+        else return false;
+        return true;
+    }
+    if (key == "enemy_kind") {
+        scenario.enemyKind = value == "mixed" ? NO_ENEMY_KIND : findEnemyKind(value);
+        return value == "mixed" || scenario.enemyKind != NO_ENEMY_KIND;
+    }
+    if (key == "max_ticks") return (bool)(in >> scenario.maxTicks);
+    if (key == "headless") return (bool)(in >> scenario.headless);
+    return false;
+}
+
+bool loadStressScenario(const std::string& fileName, StressScenario& scenario) {
+    std::ifstream file(fileName);
+    if (!file) {
+        std::cerr << "Não foi possível abrir o cenário: " << fileName << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        size_t equals = line.find('=');
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+        std::string key, value;
+        if (equals != std::string::npos) {
+            std::istringstream(line.substr(0, equals)) >> key;
+            std::istringstream(line.substr(equals + 1)) >> value;
+        }
+        if (key.empty() || !setStressOption(scenario, key, value)) {
+            std::cerr << fileName << ":" << lineNumber << ": opção inválida: " << line << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Memória residente do processo em MB (atual e pico)
+void getProcessMemoryMB(double& currentMB, double& peakMB) {
+    currentMB = peakMB = 0.0;
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        currentMB = counters.WorkingSetSize / (1024.0 * 1024.0);
+        peakMB = counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+    }
+#else
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    while (status >> key) {
+        double kb = 0.0;
+        if (key == "VmRSS:" && status >> kb) currentMB = kb / 1024.0;
+        else if (key == "VmHWM:" && status >> kb) peakMB = kb / 1024.0;
+    }
+#endif
 }
 
-// Funções do jogo
-void initGame() {
-    money = 120.0f;
-    lives = 10;
-    currentWave = 0;
-    enemies.clear();
-    towers.clear();
-    projectiles.clear();
-    placingTowerType = "";
-    waveInProgress = false;
-    gameOver = false;
-    frameCount = 0;
+// Estado da execução de estresse atual
+struct StressRun {
+    bool active = false;
+    StressScenario scenario;
+    TimingSamples tickTimes;
+    TimingSamples frameTimes;
+    long long ticks = 0;
+    size_t peakEnemies = 0;
+    size_t peakProjectiles = 0;
+    std::chrono::steady_clock::time_point start;
+};
+
+StressRun stressRun;
+
+// Prepara a partida de estresse: configura a simulação e preenche a grade de torres fora do caminho
+void setupStressScenario(const StressScenario& scenario) {
+    simConfig.startMoney = 0.0f;
+    simConfig.startLives = 1000000000; // Inimigos que escapam não encerram o teste
+    simConfig.maxWaves = scenario.waves;
+    simConfig.enemiesPerWaveBase = scenario.enemiesPerWave;
+    simConfig.enemiesPerWaveGrowth = 0;
+    simConfig.spawnDelay = scenario.spawnDelay;
+    simConfig.spawnBatch = scenario.spawnBatch;
+    simConfig.enemySpeedScale = scenario.enemySpeedScale;
+    simConfig.projectileSpeed = scenario.projectileSpeed;
+    simConfig.projectileMode = scenario.projectileMode;
+    simConfig.enemyKind = scenario.enemyKind;
+
+    initGame();
+    for (int row = 0; row < scenario.towerRows; row++) {
+        for (int column = 0; column < scenario.towerColumns; column++) {
+            float x = (column + 0.5f) * WINDOW_WIDTH / scenario.towerColumns;
+            float y = (row + 0.5f) * WINDOW_HEIGHT / scenario.towerRows;
+            if (simConfig.mazeMode) {
+                // Labirinto: cada torre passa pelo reparo incremental; as que fechariam a saída ficam de fora
+                if (isPlacementFree(x, y) && flowFieldAllowsTower(x, y)) {
+                    addTower(x, y, scenario.towerType);
+                }
+            } else if (distanceToPath(x, y) >= TOWER_PLACEMENT_MIN_DIST_PATH) {
+                towers.emplace_back(x, y, scenario.towerType);
+            }
+        }
+    }
+    rebuildMapGrids();
+    rebuildSimTimers();
+
+    stressRun.active = true;
+    stressRun.scenario = scenario;
+    stressRun.tickTimes = TimingSamples();
+    stressRun.frameTimes = TimingSamples();
+    stressRun.ticks = 0;
+    stressRun.peakEnemies = 0;
+    stressRun.peakProjectiles = 0;
+    stressRun.start = std::chrono::steady_clock::now();
 }
 
-void spawnWave() {
-    enemiesLeftToSpawn = ENEMIES_PER_WAVE_BASE + (currentWave * 2);
-    lastEnemySpawnTime = frameCount;
-    // Agora, em vez de criar todos os inimigos de uma vez,
-    // vamos criar apenas o primeiro e configurar o contador
-    if (enemiesLeftToSpawn > 0) {
-        enemies.emplace_back(currentWave);
-        enemiesLeftToSpawn--;
+// Um tick do cenário: inicia as ondas automaticamente e mede update().
+// Retorna false quando o cenário terminou
+bool stressTick() {
+    if (gameOver || (stressRun.scenario.maxTicks > 0 && stressRun.ticks >= stressRun.scenario.maxTicks)) {
+        return false;
     }
+    if (!waveInProgress) startWave();
+
+    auto start = std::chrono::steady_clock::now();
+    update();
+    stressRun.tickTimes.add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    stressRun.ticks++;
+    stressRun.peakEnemies = std::max(stressRun.peakEnemies, enemyCount());
+    stressRun.peakProjectiles = std::max(stressRun.peakProjectiles, projectiles.size() + ballisticProjectilesInFlight());
+    return true;
 }
 
-void startWave() {
-    if (gameOver || waveInProgress) return;
-    waveInProgress = true;
-    currentWave++;
-    spawnWave();
+void printStressReport() {
+    const StressScenario& sc = stressRun.scenario;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - stressRun.start).count();
+    double simSeconds = stressRun.tickTimes.total / 1000.0;
+    double currentMB, peakMB;
+    getProcessMemoryMB(currentMB, peakMB);
+
+    std::cout << std::endl << "=== Relatório de estresse (" << (sc.headless ? "headless" : "janela") << ") ===" << std::endl;
+    std::cout << "Cenário: " << sc.enemiesPerWave << " inimigos x " << sc.waves << " ondas | spawn " << sc.spawnBatch
+              << " a cada " << sc.spawnDelay << " ticks | grade " << sc.towerColumns << "x" << sc.towerRows
+              << " (" << towers.size() << " torres " << towerTypes[sc.towerType].key << ") | projétil " << sc.projectileSpeed
+              << (sc.projectileMode == PROJECTILE_HOMING ? " teleguiado" : sc.projectileMode == PROJECTILE_BALLISTIC ? " balístico" : "")
+              << " | inimigos " << (sc.enemyKind == NO_ENEMY_KIND ? "mistos" : enemyKinds[sc.enemyKind].key)
+              << " | velocidade x" << sc.enemySpeedScale << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Ticks: " << stressRun.ticks << " em " << seconds << " s | " << stressRun.ticks / std::max(simSeconds, 1e-9)
+              << " ticks/s (só simulação) | pico: " << stressRun.peakEnemies << " inimigos, "
+              << stressRun.peakProjectiles << " projéteis" << std::endl;
+    stressRun.tickTimes.print("Tempo de tick");
+    stressRun.frameTimes.print("Tempo de frame");
+    if (simConfig.mazeMode) {
+        std::cout << std::setprecision(3) << "Flow field " << flowField.columns << "x" << flowField.rows << ": "
+                  << flowField.repairs << " reparos incrementais | média " << flowField.averageRepairMs()
+                  << " ms | máx " << flowField.maxRepairMs << " ms" << std::endl;
+    }
+    if (simConfig.crowdSeparation && crowdStats.ticks > 0) {
+        std::cout << std::setprecision(3) << "Separação de multidão (" << simConfig.crowdThreads << " thread(s)): média "
+                  << crowdStats.totalMs / crowdStats.ticks << " ms | máx " << crowdStats.maxMs << " ms | pico "
+                  << crowdStats.peakAgents << " inimigos" << std::endl;
+    }
+    long long enemyTicks = pathLodStats.activeEnemyTicks + pathLodStats.dormantEnemyTicks;
+    if (pathLodActive() && enemyTicks > 0) {
+        std::cout << std::setprecision(1) << "Nível de detalhe: " << 100.0 * pathLodStats.dormantEnemyTicks / enemyTicks
+                  << "% dos inimigos-tick dormentes | " << pathLodStats.wakes << " despertares" << std::endl;
+    }
+    std::cout << std::setprecision(1) << "Memória: " << currentMB << " MB (pico " << peakMB << " MB)" << std::endl;
 }
 
-bool canPlaceTower(float x, float y) {
-    const float TOWER_COST_BASIC = 50.0f;
-const float TOWER_COST_ADVANCED = 70.0f;
-const float TOWER_RANGE_BASIC = 120.0f;
-const float TOWER_RANGE_ADVANCED = 150.0f;
-const float TOWER_DAMAGE_BASIC = 0.35f;
-const float TOWER_DAMAGE_ADVANCED = 0.80f;
-const int TOWER_FIRE_RATE_BASIC = 10;
-const int TOWER_FIRE_RATE_ADVANCED = 50;
-const float ENEMY_HEALTH_BASE = 60.0f;
-const float ENEMY_SPEED_BASE = 0.003f;
-const float ENEMY_REWARD_BASE = 10.0f;
-const int ENEMIES_PER_WAVE_BASE = 5;
-const int ENEMY_SPAWN_DELAY = 700; // Frames entre spawns de inimigos
+int runHeadlessStress(const StressScenario& scenario) {
+    updatePath();
+    setupStressScenario(scenario);
+    while (stressTick()) {
+        endAllocationFrame();
+    }
+    flushLog();
+    printStressReport();
+    saveProfilerTrace();
+    return printAllocationReport() ? 0 : 1;
+}
 
-    const float TOWER_PLACEMENT_MIN_DIST_PATH = 30.0f;
-    const float TOWER_PLACEMENT_MIN_DIST_TOWER = 40.0f;
+// ===================== Benchmarks =====================
+
+// --bench [filtro] mede os caminhos quentes da simulação e da preparação do render, cada um em vários
+// tamanhos (--bench-sizes). Cada amostra repete a operação até durar BENCH_MIN_SAMPLE_MS; depois de
+// BENCH_WARMUP_SAMPLES amostras descartadas, o resultado é a mediana e o MAD (desvio absoluto mediano)
+// do tempo por operação em --bench-reps amostras. --bench-json grava os resultados para comparar builds
+const int BENCH_WARMUP_SAMPLES = 3;
+const double BENCH_MIN_SAMPLE_MS = 2.0;
+const int BENCH_TOWERS = 64;
+const int BENCH_PROJECTILE_TARGETS = 1000;
+
+struct BenchOptions {
+    std::string filter;               // Só os casos cujo nome contém o filtro
+    std::string jsonFile;
+    std::vector<int> sizes = {100, 1000, 10000};
+    int repetitions = 21;
+};
 
-    // Verificar distância de outras torres
-    for (const auto& tower : towers) {
-        float dx = tower.position.x - x;
-        float dy = tower.position.y - y;
-        float distance = sqrt(dx * dx + dy * dy);
-        if (distance < TOWER_PLACEMENT_MIN_DIST_TOWER) {
-            showFeedback("Muito perto de outra torre!");
-            return false;
-        }
+struct BenchCase {
+    const char* name;
+    const char* unit;                  // O que 'items' conta
+    int maxIterations;                 // Teto de operações por amostra (1 quando 'run' consome o estado)
+    std::function<long long(int)> setup; // Monta o estado para o tamanho; retorna os itens por operação
+    std::function<void()> reset;       // Antes de cada amostra, fora da medição (opcional)
+    std::function<void()> run;
+};
+
+struct BenchResult {
+    std::string name;
+    std::string unit;
+    int size = 0;
+    long long items = 0;
+    int iterations = 0;
+    int repetitions = 0;
+    double medianNs = 0.0;
+    double madNs = 0.0;
+    double minNs = 0.0;
+};
+
+volatile float benchSink = 0.0f;      // Impede o compilador de descartar o trabalho medido
+std::mt19937 benchRandom;
+std::vector<unsigned char> benchSnapshot;
+std::vector<Projectile> benchProjectiles;
+std::vector<Point> benchPoints;
+std::string benchText;
+
+// Partida nova em 1920x1080 com as opções padrão, para os resultados não dependerem da linha de comando
+void benchResetWorld() {
+    WINDOW_WIDTH = 1920;
+    WINDOW_HEIGHT = 1080;
+    simConfig = SimConfig();
+    updatePath();
+    initGame();
+    benchRandom.seed(42);
+}
+
+void benchAddTowers() {
+    std::uniform_real_distribution<float> x(0.0f, (float)WINDOW_WIDTH);
+    std::uniform_real_distribution<float> y(0.0f, (float)WINDOW_HEIGHT);
+    for (int attempt = 0; attempt < 10000 && (int)towers.size() < BENCH_TOWERS; attempt++) {
+        float px = x(benchRandom);
+        float py = y(benchRandom);
+        if (isPlacementFree(px, py)) addTower(px, py, (int)towers.size() % TOWER_TYPE_COUNT);
     }
+}
 
-    // Verificar distância do caminho
-    for (int i = 0; i < path.size() - 1; i++) {
-        Point p1 = path[i];
-        Point p2 = path[i + 1];
-        
-        float distToP1 = sqrt((x - p1.x) * (x - p1.x) + (y - p1.y) * (y - p1.y));
-        float distToP2 = sqrt((x - p2.x) * (x - p2.x) + (y - p2.y) * (y - p2.y));
-        
-        if (distToP1 < TOWER_PLACEMENT_MIN_DIST_PATH || distToP2 < TOWER_PLACEMENT_MIN_DIST_PATH) {
-            showFeedback("Muito perto do caminho!");
-            return false;
+// Inimigos da onda 1 espalhados ao longo do caminho
+void benchSpawnEnemies(int count) {
+    currentWave = 1;
+    for (int i = 0; i < count; i++) {
+        unsigned char kind = enemyKindFor(currentWave, i);
+        pendingSpawns.push_back({Enemy(currentWave, kind), initialEnemyState(currentWave, kind)});
+    }
+    flushEnemyCommands();
+    std::uniform_real_distribution<float> along(0.0f, pathCorners.back() * 0.95f);
+    forEachOccupiedTable([&](EnemyTable& table) {
+        EnemyColumns& state = table.state;
+        for (size_t row = 0; row < table.enemies.size(); row++) {
+            Enemy& enemy = table.enemies[row];
+            float progress = state.progress[row] = state.anchorProgress[row] = along(benchRandom);
+            enemy.pathIndex = (int)(std::upper_bound(pathCorners.begin(), pathCorners.end(), progress) - pathCorners.begin()) - 1;
+            state.anchorTick[row] = frameCount;
+            enemy.placeOnPath(progress);
+        }
+    });
+}
+
+// Sem janela não há glifos do FreeType: métricas sintéticas bastam para medir a parte de CPU de RenderText
+void benchFillCharacters() {
+    if (!Characters.empty()) return;
+    auto add = [](int codepoint) {
+        Characters[codepoint] = {0, Point(12.0f, 17.0f), Point(1.0f, 17.0f), 14 << 6};
+    };
+    for (int c = 32; c < 127; c++) add(c);
+    size_t pos = 0;
+    while (pos < EXTENDED_CHARS.length()) add(utf8_next(EXTENDED_CHARS, pos));
+}
+
+void benchBuildText(int codepoints) {
+    static const char* sample = "Torre de gelo: lentidão até a próxima onda! ção ã é ";
+    benchText.clear();
+    for (int count = 0; count < codepoints;) {
+        std::string_view piece = sample;
+        size_t pos = 0;
+        while (pos < piece.length() && count < codepoints) {
+            size_t start = pos;
+            utf8_next(piece, pos);
+            benchText.append(piece.substr(start, pos - start));
+            count++;
         }
     }
+}
 
-    return true;
+std::vector<BenchCase> benchCases() {
+    return {
+        // Escolha de alvo de um tick com todas as torres prontas, incluindo o índice quando ele é usado
+        {"Tower::findTarget", "torre", 1 << 20,
+         [](int size) {
+             benchResetWorld();
+             benchAddTowers();
+             benchSpawnEnemies(size);
+             return (long long)towers.size();
+         },
+         nullptr,
+         [] {
+             bool indexed = useProgressIndex(towers.size());
+             if (indexed) buildProgressIndex();
+             for (auto& tower : towers) {
+                 if (indexed) tower.findTarget();
+                 else tower.findTargetBruteForce();
+                 benchSink = benchSink + (float)tower.targetId;
+             }
+         }},
+        // Enemy::update virou o passo de movimento do ECS; o snapshot volta as posições a cada amostra
+        {"moveEnemies", "inimigo", 16,
+         [](int size) {
+             benchResetWorld();
+             benchSpawnEnemies(size);
+             captureSnapshot(benchSnapshot);
+             return (long long)size;
+         },
+         [] { restoreSnapshot(benchSnapshot); },
+         [] {
+             moveEnemies();
+             frameCount++;
+         }},
+        // 10% dos projéteis perderam o alvo e saem no erase
+        {"updateProjectiles", "projétil", 1,
+         [](int size) {
+             benchResetWorld();
+             benchSpawnEnemies(BENCH_PROJECTILE_TARGETS);
+             std::vector<unsigned int> ids;
+             forEachEnemy<>([&](const Enemy& enemy) { ids.push_back(enemy.id); });
+             std::uniform_real_distribution<float> x(0.0f, (float)WINDOW_WIDTH);
+             std::uniform_real_distribution<float> y(0.0f, (float)WINDOW_HEIGHT);
+             benchProjectiles.clear();
+             for (int i = 0; i < size; i++) {
+                 unsigned int target = i % 10 == 0 ? 0 : ids[benchRandom() % ids.size()];
+                 benchProjectiles.emplace_back(Point(x(benchRandom), y(benchRandom)), target, 10.0f, COLOR_TEXT_UI, TOWER_BASIC);
+             }
+             projectiles.reserve(benchProjectiles.size());
+             return (long long)size;
+         },
+         [] { projectiles = benchProjectiles; },
+         [] { updateProjectiles(); }},
+        {"canPlaceTower", "ponto", 1 << 20,
+         [](int size) {
+             benchResetWorld();
+             benchAddTowers();
+             std::uniform_real_distribution<float> x(0.0f, (float)WINDOW_WIDTH);
+             std::uniform_real_distribution<float> y(0.0f, (float)WINDOW_HEIGHT);
+             benchPoints.clear();
+             for (int i = 0; i < size; i++) benchPoints.emplace_back(x(benchRandom), y(benchRandom));
+             return (long long)size;
+         },
+         nullptr,
+         [] {
+             int free = 0;
+             for (const Point& point : benchPoints) free += canPlaceTower(point.x, point.y);
+             benchSink = benchSink + (float)free;
+         }},
+        {"utf8_next", "caractere", 1 << 20,
+         [](int size) {
+             benchBuildText(size);
+             return (long long)size;
+         },
+         nullptr,
+         [] {
+             std::string_view text = benchText;
+             size_t pos = 0;
+             int sum = 0;
+             while (pos < text.length()) sum += utf8_next(text, pos);
+             benchSink = benchSink + (float)sum;
+         }},
+        {"RenderText (CPU)", "glifo", 1 << 20,
+         [](int size) {
+             benchFillCharacters();
+             benchBuildText(size);
+             return (long long)size;
+         },
+         nullptr,
+         [] {
+             float sum = 0.0f;
+             forEachGlyph(benchText, 20.0f, 500.0f, 0.8f, [&](const Character&, const float (&vertices)[6][4]) {
+                 sum += vertices[0][0] + vertices[5][1];
+             });
+             benchSink = benchSink + sum;
+         }},
+        {"hslToRgb", "cor", 1 << 20,
+         [](int size) {
+             benchPoints.clear();
+             std::uniform_real_distribution<float> hue(0.0f, 360.0f);
+             for (int i = 0; i < size; i++) benchPoints.emplace_back(hue(benchRandom), 0.0f);
+             return (long long)size;
+         },
+         nullptr,
+         [] {
+             float sum = 0.0f;
+             for (const Point& point : benchPoints) {
+                 Color color = hslToRgb(point.x, 0.8f, 0.6f);
+                 sum += color.r + color.g + color.b;
+             }
+             benchSink = benchSink + sum;
+         }},
+    };
 }
 
-void placeTower(float x, float y) {
-    if (placingTowerType.empty() || gameOver) return;
-    
-    if (money >= towerTypes[placingTowerType].cost && canPlaceTower(x, y)) {
-        towers.emplace_back(x, y, placingTowerType);
-        money -= towerTypes[placingTowerType].cost;
-        placingTowerType = "";
-        showFeedback("Torre colocada com sucesso!");
+double benchMedian(std::vector<double> values) {
+    size_t middle = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + middle, values.end());
+    return values[middle];
+}
+
+BenchResult runBenchCase(const BenchCase& bench, int size, int repetitions) {
+    BenchResult result;
+    result.name = bench.name;
+    result.unit = bench.unit;
+    result.size = size;
+    result.items = bench.setup(size);
+    auto sample = [&](int iterations) {
+        if (bench.reset) bench.reset();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) bench.run();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // Calibração: dobra as operações por amostra até a amostra durar BENCH_MIN_SAMPLE_MS
+    int iterations = 1;
+    while (iterations < bench.maxIterations && sample(iterations) < BENCH_MIN_SAMPLE_MS * 1e6) iterations *= 2;
+    iterations = std::min(iterations, bench.maxIterations);
+    for (int i = 0; i < BENCH_WARMUP_SAMPLES; i++) sample(iterations);
+
+    std::vector<double> times(repetitions);
+    for (double& time : times) time = sample(iterations) / iterations;
+    result.iterations = iterations;
+    result.repetitions = repetitions;
+    result.medianNs = benchMedian(times);
+    result.minNs = *std::min_element(times.begin(), times.end());
+    std::vector<double> deviations(times.size());
+    for (size_t i = 0; i < times.size(); i++) deviations[i] = std::fabs(times[i] - result.medianNs);
+    result.madNs = benchMedian(deviations);
+    return result;
+}
+
+bool writeBenchJson(const std::string& fileName, const std::vector<BenchResult>& results) {
+    FILE* file = std::fopen(fileName.c_str(), "w");
+    if (!file) {
+        std::cerr << "Não foi possível gravar os benchmarks em " << fileName << std::endl;
+        return false;
     }
+    std::fprintf(file, "{\"benchmarks\":[\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        std::fprintf(file, "{\"name\":\"%s\",\"size\":%d,\"items\":%lld,\"unit\":\"%s\",\"iterations\":%d,\"repetitions\":%d,"
+                     "\"median_ns\":%.1f,\"mad_ns\":%.1f,\"min_ns\":%.1f,\"ns_per_item\":%.3f}%s\n",
+                     r.name.c_str(), r.size, r.items, r.unit.c_str(), r.iterations, r.repetitions, r.medianNs, r.madNs,
+                     r.minNs, r.items > 0 ? r.medianNs / r.items : 0.0, i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "]}\n");
+    std::fclose(file);
+    return true;
 }
 
-void selectTowerType(const std::string& type) {
-    if (gameOver) return;
-    
-    if (money >= towerTypes[type].cost) {
-        placingTowerType = type;
-        showFeedback("Torre " + towerTypes[type].name + " selecionada. Clique para colocar.");
-    } else {
-        showFeedback("Dinheiro insuficiente para Torre " + towerTypes[type].name + ".");
+int runBenchmarks(const BenchOptions& options) {
+    std::vector<BenchResult> results;
+    std::cout << std::fixed;
+    for (const BenchCase& bench : benchCases()) {
+        if (std::string(bench.name).find(options.filter) == std::string::npos) continue;
+        for (int size : options.sizes) {
+            BenchResult result = runBenchCase(bench, size, options.repetitions);
+            std::cout << std::left << std::setw(20) << result.name << std::right << std::setw(7) << size
+                      << std::setprecision(1) << " | mediana " << std::setw(11) << result.medianNs << " ns | MAD "
+                      << std::setw(8) << result.madNs << " ns (" << std::setw(4)
+                      << (result.medianNs > 0.0 ? 100.0 * result.madNs / result.medianNs : 0.0) << "%) | "
+                      << std::setprecision(2) << result.medianNs / std::max(1LL, result.items) << " ns/" << result.unit
+                      << std::endl;
+            results.push_back(result);
+        }
     }
+    std::cout << std::defaultfloat;
+    if (results.empty()) {
+        std::cerr << "Nenhum benchmark corresponde a \"" << options.filter << "\"" << std::endl;
+        return 1;
+    }
+    if (!options.jsonFile.empty()) {
+        if (!writeBenchJson(options.jsonFile, results)) return 1;
+        std::cout << "Resultados em " << options.jsonFile << std::endl;
+    }
+    return 0;
 }
 
-void update() {
-    if (gameOver) return;
+// ===================== Replay de sessões =====================
+
+// --replay <arquivo|pasta> repete cada sessão gravada (--record) pelo pipeline completo: as ações na
+// iteração gravada, update(), snapshots e render() numa janela invisível (sem contexto OpenGL, só a
+// simulação). Mede tick, frame, draw calls e alocações, confere o estado final com a linha "fim" da
+// gravação e compara as métricas com uma baseline (--replay-baseline), acusando o que piorar além da
+// tolerância. Métricas terminadas em "_ms" são tempos; as demais, contagens
+const double REPLAY_TIME_SLACK_MS = 0.005; // Folga absoluta: diferenças menores nos tempos são ruído
+
+struct ReplayOptions {
+    std::vector<std::string> inputs;
+    std::string baselineFile;
+    std::string saveBaselineFile;
+    double timeTolerance = 20.0;   // % acima da baseline aceitos para tempos
+    double countTolerance = 5.0;   // % acima da baseline aceitos para draw calls e alocações
+    bool render = true;
+};
 
-    // Verificar se é hora de gerar mais inimigos
-    if (waveInProgress && enemiesLeftToSpawn > 0 && 
-        (frameCount - lastEnemySpawnTime >= ENEMY_SPAWN_DELAY)) {
-        enemies.emplace_back(currentWave);
-        enemiesLeftToSpawn--;
-        lastEnemySpawnTime = frameCount;
-    }
+typedef std::map<std::string, double> ReplayMetrics;
 
-    // Atualizar torres
-    for (auto& tower : towers) {
-        tower.update(enemies, projectiles, frameCount);
+// Arquivos .txt das pastas (em ordem alfabética) e arquivos avulsos, na ordem dada
+std::vector<std::string> collectSessionFiles(const std::vector<std::string>& inputs) {
+    std::vector<std::string> files;
+    for (const std::string& input : inputs) {
+        std::error_code error;
+        if (!std::filesystem::is_directory(input, error)) {
+            files.push_back(input);
+            continue;
+        }
+        std::vector<std::string> found;
+        for (const auto& entry : std::filesystem::directory_iterator(input, error)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".txt") found.push_back(entry.path().string());
+        }
+        std::sort(found.begin(), found.end());
+        files.insert(files.end(), found.begin(), found.end());
     }
+    return files;
+}
 
-    // Atualizar projéteis
-    projectiles.erase(
-        std::remove_if(projectiles.begin(), projectiles.end(),
-            [](Projectile& p) {
-                p.update();
-                return p.damage <= 0 || p.hasHit;
-            }),
-        projectiles.end()
-    );
+// Repete uma sessão; retorna false se ela não pôde ser lida ou se o estado final diverge da gravação
+bool replaySession(const std::string& fileName, GLFWwindow* window, ReplayMetrics& metrics) {
+    Session session;
+    if (!loadSession(fileName, session)) return false;
 
-    // Atualizar inimigos
-    enemies.erase(
-        std::remove_if(enemies.begin(), enemies.end(),
-            [](Enemy& e) {
-                e.update();
-                return e.health <= 0;
-            }),
-        enemies.end()
-    );
+    WINDOW_WIDTH = session.width;
+    WINDOW_HEIGHT = session.height;
+    simConfig = session.config;
+    pathShape = session.shape;
+    updatePath();
+    initGame();
+    simulationSeed = session.seed;
+    snapshotRing.clear();
+    if (window) {
+        glfwSetWindowSize(window, session.width, session.height);
+        glViewport(0, 0, session.width, session.height);
+    }
 
-    // Verificar fim da onda
-    if (waveInProgress && enemies.empty() && enemiesLeftToSpawn == 0) {
-        waveInProgress = false;
-        if (currentWave >= 10) {
-            gameOver = true;
+    long long ticks = session.ticks;
+    if (ticks < 0) ticks = session.actions.empty() ? 0 : session.actions.back().tick + 1;
+    bool tracking = allocationTracking.exchange(true);
+    allocationReport = AllocationReport();
+    allocationReport.warmupFrames = 0;
+    TimingSamples tickTimes;
+    TimingSamples frameTimes;
+    long long drawCalls = 0;
+    size_t next = 0;
+    for (long long tick = 0; tick < ticks; tick++) {
+        for (; next < session.actions.size() && session.actions[next].tick <= tick; next++) {
+            applySessionAction(session.actions[next]);
+            if (window && session.actions[next].kind == SESSION_RESIZE) glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+        }
+        auto start = std::chrono::steady_clock::now();
+        update();
+        snapshotRing.onTick();
+        tickTimes.add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        updateUiTimers(tick * 1000 / 60);
+        if (window) {
+            start = std::chrono::steady_clock::now();
+            render();
+            frameTimes.add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            glfwSwapBuffers(window);
         }
+        frameArena.reset();
+        endAllocationFrame();
+        renderStats.endFrame();
+        drawCalls += renderStats.lastDrawCalls;
+    }
+    allocationTracking = tracking;
+
+    metrics.clear();
+    metrics["tick_p50_ms"] = tickTimes.percentile(0.50f);
+    metrics["tick_p95_ms"] = tickTimes.percentile(0.95f);
+    metrics["tick_p99_ms"] = tickTimes.percentile(0.99f);
+    if (window) {
+        metrics["frame_p50_ms"] = frameTimes.percentile(0.50f);
+        metrics["frame_p95_ms"] = frameTimes.percentile(0.95f);
+        metrics["frame_p99_ms"] = frameTimes.percentile(0.99f);
+        metrics["draws_por_frame"] = ticks > 0 ? (double)drawCalls / ticks : 0.0;
     }
+    metrics["alocacoes_por_tick"] = ticks > 0 ? (double)allocationReport.total.taggedAllocations() / ticks : 0.0;
 
-    frameCount++;
+    std::cout << "[" << fileName << "] " << ticks << " ticks | estado: dinheiro " << money << " vidas " << lives
+              << " onda " << currentWave << " inimigos " << enemyCount();
+    if (session.ticks < 0) {
+        std::cout << " (a gravação não tem estado final)" << std::endl;
+        return true;
+    }
+    bool same = std::fabs(money - session.money) < 0.01f && lives == session.lives && currentWave == session.wave
+                && enemyCount() == session.enemies;
+    if (same) {
+        std::cout << " | OK" << std::endl;
+    } else {
+        std::cout << std::endl << "  DIVERGÊNCIA: gravado dinheiro " << session.money << " vidas " << session.lives
+                  << " onda " << session.wave << " inimigos " << session.enemies << std::endl;
+    }
+    return same;
 }
 
-void render() {
-    glClearColor(0.1f, 0.12f, 0.15f, 1.0f); // Nova cor de fundo
-    glClear(GL_COLOR_BUFFER_BIT);
-    glEnable(GL_BLEND); // Habilitar blend para texto e formas transparentes
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    
-    // Desenhar caminho
-    drawPath();
-    
-    // Desenhar torres
-    for (const auto& tower : towers) {
-        drawTower(tower);
+// Baseline: uma linha "<sessão> <métrica> <valor>" por métrica
+bool loadReplayBaseline(const std::string& fileName, std::map<std::string, ReplayMetrics>& baseline) {
+    std::ifstream in(fileName);
+    if (!in) {
+        std::cerr << "Não foi possível abrir a baseline: " << fileName << std::endl;
+        return false;
     }
-    
-    // Desenhar projéteis
-    for (const auto& projectile : projectiles) {
-        drawProjectile(projectile);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string session, metric;
+        double value;
+        if (fields >> session >> metric >> value) baseline[session][metric] = value;
     }
-    
-    // Desenhar inimigos
-    for (const auto& enemy : enemies) {
-        drawEnemy(enemy);
+    return true;
+}
+
+bool saveReplayBaseline(const std::string& fileName, const std::vector<std::pair<std::string, ReplayMetrics>>& results) {
+    std::ofstream out(fileName);
+    if (!out) {
+        std::cerr << "Não foi possível gravar a baseline em " << fileName << std::endl;
+        return false;
     }
-    
-    // Preview da torre sendo colocada
-    if (!placingTowerType.empty()) {
-        double mouseX_local, mouseY_local;
-        glfwGetCursorPos(glfwGetCurrentContext(), &mouseX_local, &mouseY_local);
-        
-        // Inverter Y para coordenadas OpenGL
-        mouseY_local = WINDOW_HEIGHT - mouseY_local;
-        
-        // Ajustar o raio e alcance proporcionalmente ao tamanho da janela
-        float heightRatio = static_cast<float>(WINDOW_HEIGHT) / 720.0f;
-        float previewRadius = 20.0f * heightRatio;
-        float previewRange = towerTypes[placingTowerType].range * heightRatio;
-        
-        // Primeiro desenhar o círculo de alcance (mais transparente)
-        Color rangeColor(0.5f, 0.5f, 0.5f, 0.3f); // Cor mais visível para o range
-        drawCircle((float)mouseX_local, (float)mouseY_local, previewRange, rangeColor);
-        
-        // Depois desenhar a torre
-        Color previewColor = towerTypes[placingTowerType].color;
-        previewColor.a = 0.7f; // Aumentar opacidade
-        drawCircle((float)mouseX_local, (float)mouseY_local, previewRadius, previewColor);
-        
-        // Não precisamos mais desenhar o contorno separadamente já que o círculo de range já está visível
+    out << "# Baseline de replays: <sessão> <métrica> <valor>" << std::endl << std::setprecision(6);
+    for (const auto& result : results) {
+        for (const auto& metric : result.second) out << result.first << " " << metric.first << " " << metric.second << std::endl;
     }
-    
-    // Desenhar interface
-    drawUI();
+    return true;
 }
 
-// Callbacks do GLFW
-void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
-    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
-        double mouseX, mouseY;
-        glfwGetCursorPos(window, &mouseX, &mouseY);
-        mouseY = WINDOW_HEIGHT - mouseY; // Inverter Y
-        placeTower(mouseX, mouseY);
+// Retorna quantas métricas pioraram além da tolerância
+int compareReplayMetrics(const std::string& session, const ReplayMetrics& metrics, const ReplayMetrics& baseline,
+                         const ReplayOptions& options) {
+    int regressions = 0;
+    for (const auto& metric : metrics) {
+        auto found = baseline.find(metric.first);
+        if (found == baseline.end()) continue;
+        bool isTime = metric.first.size() > 3 && metric.first.compare(metric.first.size() - 3, 3, "_ms") == 0;
+        double tolerance = isTime ? options.timeTolerance : options.countTolerance;
+        double limit = found->second * (1.0 + tolerance / 100.0) + (isTime ? REPLAY_TIME_SLACK_MS : 1e-9);
+        if (metric.second > limit) {
+            std::cout << "  REGRESSÃO " << session << " " << metric.first << ": " << metric.second << " (baseline "
+                      << found->second << ", limite " << limit << ")" << std::endl;
+            regressions++;
+        }
     }
+    return regressions;
 }
 
-void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
-    if (action == GLFW_PRESS) {
-        switch (key) {
-            case GLFW_KEY_1:
-                selectTowerType("basic");
-                break;
-            case GLFW_KEY_2:
-                selectTowerType("advanced");
-                break;
-            case GLFW_KEY_SPACE:
-                startWave();
-                break;
-            case GLFW_KEY_R:
-                if (gameOver) {
-                    initGame();
-                }
-                break;
-            case GLFW_KEY_ESCAPE:
-                placingTowerType = "";
-                showFeedback("Seleção de torre cancelada");
-                break;
+int runReplays(const ReplayOptions& options) {
+    std::vector<std::string> files = collectSessionFiles(options.inputs);
+    if (files.empty()) {
+        std::cerr << "Nenhuma sessão para repetir" << std::endl;
+        return 1;
+    }
+    std::map<std::string, ReplayMetrics> baseline;
+    if (!options.baselineFile.empty() && !loadReplayBaseline(options.baselineFile, baseline)) return 1;
+
+    // Janela invisível para medir render(); sem ela (sem display, por exemplo) só a simulação é medida
+    GLFWwindow* window = nullptr;
+    if (options.render && glfwInit()) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Tower Defense (replay)", NULL, NULL);
+        if (window) {
+            glfwMakeContextCurrent(window);
+            if (gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+                glfwSwapInterval(0);
+                updatePath();
+                initOpenGL();
+            } else {
+                glfwDestroyWindow(window);
+                window = nullptr;
+            }
         }
     }
+    if (options.render && !window) LOG_WARN("replay", "sem contexto OpenGL: só a simulação será medida");
+    flushLog();
+
+    int failures = 0;
+    int regressions = 0;
+    std::vector<std::pair<std::string, ReplayMetrics>> results;
+    for (const std::string& file : files) {
+        ReplayMetrics metrics;
+        if (!replaySession(file, window, metrics)) failures++;
+        std::string name = std::filesystem::path(file).filename().string();
+        std::cout << std::fixed << std::setprecision(3) << "  ";
+        for (const auto& metric : metrics) std::cout << metric.first << " " << metric.second << "  ";
+        std::cout << std::defaultfloat << std::endl;
+        auto found = baseline.find(name);
+        if (found != baseline.end()) regressions += compareReplayMetrics(name, metrics, found->second, options);
+        results.push_back({name, metrics});
+    }
+    if (window) glfwTerminate();
+
+    if (!options.saveBaselineFile.empty() && saveReplayBaseline(options.saveBaselineFile, results)) {
+        std::cout << "Baseline gravada em " << options.saveBaselineFile << std::endl;
+    }
+    std::cout << files.size() << " sessões | " << failures << " com estado divergente | " << regressions << " regressões"
+              << std::endl;
+    return failures == 0 && regressions == 0 ? 0 : 1;
 }
 
-int main() {
+// Lê "LxA" (ex: 1920x1080)
+bool parseResolution(const std::string& text, int& width, int& height) {
+    char separator = 0;
+    std::istringstream in(text);
+    return (in >> width >> separator >> height) && separator == 'x' && width > 0 && height > 0;
+}
+
+void printUsage() {
+    std::cout << "Uso: modern_tower_defense [opções]" << std::endl;
+    std::cout << "  (sem opções)            abre o jogo na janela" << std::endl;
+    std::cout << "  --evaluate <arquivo>    avalia layouts de torres sem janela" << std::endl;
+    std::cout << "  --seeds <n>             partidas (sementes) por layout (padrão 32)" << std::endl;
+    std::cout << "  --seed <n>              primeira semente (padrão 1)" << std::endl;
+    std::cout << "  --threads <n>           threads de simulação (padrão: todos os núcleos)" << std::endl;
+    std::cout << "  --search <n>            iterações de hill climbing sobre as posições" << std::endl;
+    std::cout << "  --restarts <n>          reinícios aleatórios da busca" << std::endl;
+    std::cout << "  --spawn-jitter <f>      variação do intervalo entre lotes sorteada por semente (padrão 0.25)" << std::endl;
+    std::cout << "  --min-throughput <M>    falha (código 1) abaixo de M milhões de ticks/s" << std::endl;
+    std::cout << "  --resolution <LxA>      resolução do mapa headless (padrão 1920x1080)" << std::endl;
+    std::cout << "  --placement-cell <px>   tamanho da célula do raster de posicionamento (padrão 4)" << std::endl;
+    std::cout << "  --path <arquivo>        forma do caminho (polilinha ou curva Catmull-Rom, veja paths/)" << std::endl;
+    std::cout << "  --maze                  modo labirinto: sem caminho fixo, as torres formam o percurso (tecla M)" << std::endl;
+    std::cout << "  --maze-cell <px>        tamanho da célula do flow field do labirinto (padrão 16)" << std::endl;
+    std::cout << "  --crowd                 separação de multidão: espaçamento mínimo e ultrapassagem (tecla C)" << std::endl;
+    std::cout << "  --crowd-spacing <px>    distância mínima entre inimigos (padrão 20)" << std::endl;
+    std::cout << "  --crowd-threads <n>     threads da consulta de vizinhos (padrão 1)" << std::endl;
+    std::cout << "  --no-lod                move todos os inimigos a cada tick, mesmo fora do alcance das torres" << std::endl;
+    std::cout << "  --projectile-mode <m>   type|homing|ballistic: modo de projétil de todas as torres (padrão type, teleguiado)" << std::endl;
+    std::cout << "  --enemy-kind <tipo>     normal|fast|armored|flying|boss para todos, ou mixed: ondas mistas com chefe (padrão normal)" << std::endl;
+    std::cout << "  --track-allocs          conta alocações por frame e por sistema (update, spawn, render, interface)" << std::endl;
+    std::cout << "  --alloc-check           como --track-allocs, mas falha se um frame depois do aquecimento alocar" << std::endl;
+    std::cout << "  --alloc-warmup <n>      frames de aquecimento ignorados pela checagem (padrão 300)" << std::endl;
+    std::cout << "  --hud                   abre o jogo com o HUD de desempenho visível (tecla F3)" << std::endl;
+    std::cout << "  --frames-in-flight <n>  limite de quadros na fila da GPU (padrão 2; 0 = o driver decide)" << std::endl;
+    std::cout << "  --particles <n>         capacidade de partículas na GPU (padrão 262144; 0 desliga)" << std::endl;
+    std::cout << "  --input-latency         mede a latência da entrada até o swap que a reflete e imprime ao sair" << std::endl;
+    std::cout << "  --profile [arquivo]     grava zonas do profiler num trace do Chrome (padrão perfil.json; tecla P ou na saída)" << std::endl;
+    std::cout << "  --bench [filtro]        micro-benchmarks dos caminhos quentes (mediana e MAD por tamanho)" << std::endl;
+    std::cout << "  --bench-sizes <a,b,..>  tamanhos dos benchmarks (padrão 100,1000,10000)" << std::endl;
+    std::cout << "  --bench-reps <n>        amostras medidas por caso (padrão 21)" << std::endl;
+    std::cout << "  --bench-json <arquivo>  grava os resultados em JSON" << std::endl;
+    std::cout << "  --record <arquivo>      grava as ações da partida e o estado final para --replay" << std::endl;
+    std::cout << "  --replay <arquivo|pasta> repete sessões gravadas pelo update() e render() e confere o estado final" << std::endl;
+    std::cout << "  --replay-baseline <arq> compara tempos, draw calls e alocações com uma baseline" << std::endl;
+    std::cout << "  --replay-save-baseline <arq> grava as métricas desta execução como baseline" << std::endl;
+    std::cout << "  --replay-tolerance <%>  piora aceita nos tempos (padrão 20)" << std::endl;
+    std::cout << "  --replay-count-tolerance <%> piora aceita em draw calls e alocações (padrão 5)" << std::endl;
+    std::cout << "  --replay-no-render      repete só a simulação" << std::endl;
+    std::cout << "  --stress [arquivo]      cenário de estresse (arquivo \"chave = valor\", veja scenarios/)" << std::endl;
+    std::cout << "  --headless              roda o cenário de estresse sem janela" << std::endl;
+    std::cout << "  --enemies <n> --waves <n> --spawn-delay <n> --spawn-batch <n> --enemy-speed <x>" << std::endl;
+    std::cout << "  --tower-grid <CxL> --tower-type <tipo> --projectile-speed <x> --max-ticks <n>" << std::endl;
+    std::cout << "  --projectile-mode <type|homing|ballistic> --enemy-kind <mixed|normal|fast|armored|flying|boss>" << std::endl;
+    std::cout << "                          sobrescrevem as opções do cenário" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    startLogger();
+
+    // Modos de linha de comando (sem janela)
+    EvaluatorOptions evaluatorOptions;
+    bool evaluate = false;
+    bool stress = false;
+    bool showPerfHud = false;
+    bool bench = false;
+    BenchOptions benchOptions;
+    ReplayOptions replayOptions;
+    std::string recordFile;
+    std::string stressFile;
+    std::vector<std::pair<std::string, std::string>> stressOverrides;
+    WINDOW_WIDTH = 1920;
+    WINDOW_HEIGHT = 1080;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        } else if (arg == "--evaluate" && hasValue) {
+            evaluate = true;
+            evaluatorOptions.layoutFile = argv[++i];
+        } else if (arg == "--seeds" && hasValue) {
+            evaluatorOptions.seeds = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--seed" && hasValue) {
+            evaluatorOptions.baseSeed = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--threads" && hasValue) {
+            evaluatorOptions.threads = std::atoi(argv[++i]);
+        } else if (arg == "--search" && hasValue) {
+            evaluatorOptions.searchIterations = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--restarts" && hasValue) {
+            evaluatorOptions.searchRestarts = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--spawn-jitter" && hasValue) {
+            evaluatorOptions.spawnJitter = std::clamp((float)std::atof(argv[++i]), 0.0f, 1.0f);
+        } else if (arg == "--min-throughput" && hasValue) {
+            evaluatorOptions.minTicksPerSecond = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--resolution" && hasValue) {
+            if (!parseResolution(argv[++i], WINDOW_WIDTH, WINDOW_HEIGHT)) {
+                std::cerr << "Resolução inválida: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--placement-cell" && hasValue) {
+            placementCellSize = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--path" && hasValue) {
+            if (!loadPathShape(argv[++i], pathShape)) return 1;
+        } else if (arg == "--maze") {
+            simConfig.mazeMode = true;
+        } else if (arg == "--maze-cell" && hasValue) {
+            simConfig.mazeCellSize = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--crowd") {
+            simConfig.crowdSeparation = true;
+        } else if (arg == "--crowd-spacing" && hasValue) {
+            simConfig.crowdSpacing = std::max(1.0f, (float)std::atof(argv[++i]));
+        } else if (arg == "--crowd-threads" && hasValue) {
+            simConfig.crowdThreads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--no-lod") {
+            simConfig.pathLod = false;
+        } else if (arg == "--track-allocs") {
+            allocationTracking = true;
+        } else if (arg == "--alloc-check") {
+            allocationTracking = true;
+            allocationReport.check = true;
+        } else if (arg == "--alloc-warmup" && hasValue) {
+            allocationReport.warmupFrames = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--hud") {
+            showPerfHud = true;
+        } else if (arg == "--frames-in-flight" && hasValue) {
+            framePacer.limit = std::clamp(std::atoi(argv[++i]), 0, MAX_FRAMES_IN_FLIGHT);
+        } else if (arg == "--input-latency") {
+            inputLatency.enabled = true;
+        } else if (arg == "--particles" && hasValue) {
+            particleSystem.capacity = std::clamp(std::atoi(argv[++i]), 0, PARTICLE_CAPACITY);
+        } else if (arg == "--profile") {
+            std::string fileName;
+            if (hasValue && std::string(argv[i + 1]).rfind("--", 0) != 0) fileName = argv[++i];
+            enableProfiler(fileName);
+        } else if (arg == "--bench") {
+            bench = true;
+            if (hasValue && std::string(argv[i + 1]).rfind("--", 0) != 0) benchOptions.filter = argv[++i];
+        } else if (arg == "--bench-sizes" && hasValue) {
+            benchOptions.sizes.clear();
+            std::stringstream sizes(argv[++i]);
+            std::string size;
+            while (std::getline(sizes, size, ',')) {
+                if (std::atoi(size.c_str()) > 0) benchOptions.sizes.push_back(std::atoi(size.c_str()));
+            }
+        } else if (arg == "--bench-reps" && hasValue) {
+            benchOptions.repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--bench-json" && hasValue) {
+            benchOptions.jsonFile = argv[++i];
+        } else if (arg == "--record" && hasValue) {
+            recordFile = argv[++i];
+        } else if (arg == "--replay" && hasValue) {
+            replayOptions.inputs.push_back(argv[++i]);
+        } else if (arg == "--replay-baseline" && hasValue) {
+            replayOptions.baselineFile = argv[++i];
+        } else if (arg == "--replay-save-baseline" && hasValue) {
+            replayOptions.saveBaselineFile = argv[++i];
+        } else if (arg == "--replay-tolerance" && hasValue) {
+            replayOptions.timeTolerance = std::atof(argv[++i]);
+        } else if (arg == "--replay-count-tolerance" && hasValue) {
+            replayOptions.countTolerance = std::atof(argv[++i]);
+        } else if (arg == "--replay-no-render") {
+            replayOptions.render = false;
+        } else if (arg == "--stress") {
+            stress = true;
+            if (hasValue && std::string(argv[i + 1]).rfind("--", 0) != 0) stressFile = argv[++i];
+        } else if (arg == "--enemy-kind" && hasValue) {
+            // Como --projectile-mode: vale para o jogo, o avaliador e o estresse
+            StressScenario probe;
+            if (!setStressOption(probe, "enemy_kind", argv[i + 1])) {
+                std::cerr << "Opção inválida: " << arg << " " << argv[i + 1] << std::endl;
+                printUsage();
+                return 1;
+            }
+            simConfig.enemyKind = probe.enemyKind;
+            stressOverrides.push_back({"enemy_kind", argv[++i]});
+        } else if (arg == "--projectile-mode" && hasValue) {
+            // Vale para o jogo e o avaliador; no estresse entra como "projectile_mode = ..."
+            StressScenario probe;
+            if (!setStressOption(probe, "projectile_mode", argv[i + 1])) {
+                std::cerr << "Opção inválida: " << arg << " " << argv[i + 1] << std::endl;
+                printUsage();
+                return 1;
+            }
+            simConfig.projectileMode = probe.projectileMode;
+            stressOverrides.push_back({"projectile_mode", argv[++i]});
+        } else if (arg == "--headless") {
+            stressOverrides.push_back({"headless", "1"});
+        } else if (arg.rfind("--", 0) == 0 && hasValue) {
+            // Opções do cenário de estresse: --spawn-batch 100 equivale a "spawn_batch = 100" no arquivo
+            std::string key = arg.substr(2);
+            std::replace(key.begin(), key.end(), '-', '_');
+            StressScenario probe;
+            if (!setStressOption(probe, key, argv[i + 1])) {
+                std::cerr << "Opção inválida: " << arg << " " << argv[i + 1] << std::endl;
+                printUsage();
+                return 1;
+            }
+            stressOverrides.push_back({key, argv[++i]});
+        } else {
+            std::cerr << "Opção desconhecida: " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+    }
+    if (evaluate) {
+        return runEvaluator(evaluatorOptions);
+    }
+    if (bench) {
+        return runBenchmarks(benchOptions);
+    }
+    if (!replayOptions.inputs.empty()) {
+        return runReplays(replayOptions);
+    }
+
+    StressScenario stressScenario;
+    if (stress) {
+        if (!stressFile.empty() && !loadStressScenario(stressFile, stressScenario)) return 1;
+        for (const auto& option : stressOverrides) {
+            setStressOption(stressScenario, option.first, option.second);
+        }
+        if (stressScenario.headless) {
+            return runHeadlessStress(stressScenario);
+        }
+    }
+
     // Inicializar GLFW
     if (!glfwInit()) {
         std::cerr << "Falha ao inicializar GLFW" << std::endl;
@@ -1108,6 +6963,7 @@ int main() {
     glfwSetMouseButtonCallback(window, mouseButtonCallback);
     glfwSetKeyCallback(window, keyCallback);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, cursorPositionCallback);
 
     // Obter o tamanho real da janela após a maximização
     glfwGetFramebufferSize(window, &WINDOW_WIDTH, &WINDOW_HEIGHT);
@@ -1127,7 +6983,13 @@ int main() {
     initOpenGL();
 
     // Inicializar jogo
-    initGame();
+    if (stress) {
+        setupStressScenario(stressScenario);
+    } else {
+        initGame();
+    }
+    if (showPerfHud) togglePerfHud();
+    if (!recordFile.empty() && !stress) startSessionRecording(recordFile);
 
     std::cout << "=== Tower Defense ===" << std::endl;
     std::cout << "Controles:" << std::endl;
@@ -1136,6 +6998,8 @@ int main() {
     std::cout << "Espaço - Iniciar Onda" << std::endl;
     std::cout << "R - Reiniciar (quando game over)" << std::endl;
     std::cout << "ESC - Cancelar seleção de torre" << std::endl;
+    std::cout << "Backspace - Voltar ao snapshot anterior (rewind)" << std::endl;
+    std::cout << "F3 - HUD de desempenho" << std::endl;
     std::cout << "Clique para colocar torre selecionada" << std::endl;
     std::cout << std::endl;
     std::cout << "Resolução da janela: " << WINDOW_WIDTH << "x" << WINDOW_HEIGHT << std::endl;
@@ -1145,34 +7009,71 @@ int main() {
     float lastFrameTime = (float)glfwGetTime();
     
     while (!glfwWindowShouldClose(window)) {
+        PROFILE_ZONE("frame");
+        waitForFrameSlot();
         float currentFrameTime = (float)glfwGetTime();
         float deltaTime = currentFrameTime - lastFrameTime;
         lastFrameTime = currentFrameTime;
         
         glfwPollEvents();
         
-        update();
+        auto tickStart = std::chrono::steady_clock::now();
+        applyInputCommands();
+        if (stressRun.active) {
+            if (!stressTick()) {
+                glfwSetWindowShouldClose(window, GLFW_TRUE);
+            }
+            stressRun.frameTimes.add(deltaTime * 1000.0);
+        } else {
+            update();
+            snapshotRing.onTick();
+        }
+        finishInputCommands();
+        simulationTick++;
+        perfHud.add(deltaTime * 1000.0f, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - tickStart).count());
+        updateUiTimers((long long)(glfwGetTime() * 1000.0));
         render();
         
-        glfwSwapBuffers(window);
+        {
+            PROFILE_ZONE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
+        recordInputPresent();
+        fenceFrame();
+        frameArena.reset();
+        endAllocationFrame();
+        renderStats.endFrame();
         
         // Imprimir informações do jogo
         static int lastFrame = 0;
         if (frameCount % 60 == 0 && frameCount != lastFrame) {
-            std::cout << "Dinheiro: " << money << " | Vidas: " << lives << " | Onda: " << currentWave;
-            std::cout << " | Inimigos: " << enemies.size() << " | Torres: " << towers.size() << std::endl;
+            LOG_INFO("jogo", "frame=%d dinheiro=%.0f vidas=%d onda=%d inimigos=%zu torres=%zu snapshot_us=%.1f "
+                     "snapshot_media_us=%.1f snapshot_max_us=%.1f particulas=%lld", frameCount, money, lives, currentWave, enemyCount(),
+                     towers.size(), snapshotRing.lastCaptureUs, snapshotRing.averageCaptureUs(), snapshotRing.maxCaptureUs,
+                     liveParticleCount());
+            printAllocationInterval();
             lastFrame = frameCount;
             
             if (gameOver) {
                 if (lives <= 0) {
-                    std::cout << "GAME OVER! Pressione R para reiniciar." << std::endl;
+                    LOG_INFO("jogo", "GAME OVER! Pressione R para reiniciar.");
                 } else {
-                    std::cout << "VITÓRIA! Você completou todas as ondas! Pressione R para reiniciar." << std::endl;
+                    LOG_INFO("jogo", "VITÓRIA! Você completou todas as ondas! Pressione R para reiniciar.");
                 }
             }
         }
     }
     
+    flushLog();
+    saveSessionRecording();
+    printInputLatencyReport();
+    printInputPresentReport();
+    if (stressRun.active) {
+        printStressReport();
+    }
+    bool allocationsOk = printAllocationReport();
+    saveProfilerTrace();
+
     // Limpar recursos do FreeType
     FT_Done_Face(face);
     FT_Done_FreeType(ft);
@@ -1182,17 +7083,29 @@ int main() {
     glDeleteBuffers(1, &VBO);
     glDeleteProgram(shaderProgram);
 
+    glDeleteVertexArrays(1, &pathVAO);
+    glDeleteBuffers(1, &pathVBO);
+
+    // Limpar recursos do overlay de posicionamento
+    glDeleteVertexArrays(1, &overlayVAO);
+    glDeleteBuffers(1, &overlayVBO);
+    glDeleteTextures(1, &placementTexture);
+    glDeleteProgram(overlayShaderProgram);
+    releaseFrameFences();
+
     // Limpar recursos do texto
     glDeleteVertexArrays(1, &textVAO);
     glDeleteBuffers(1, &textVBO);
     glDeleteProgram(textShaderProgram);
+    destroyParticleSystem();
 
     glfwTerminate();
-    return 0;
+    return allocationsOk ? 0 : 1;
 }
 
 // Função para inicializar OpenGL
 void initOpenGL() {
+    PROFILE_ZONE("initOpenGL");
     // Criar shader program para formas
     shaderProgram = createAndLinkShaderProgram(vertexShaderSource, fragmentShaderSource);
 
@@ -1207,24 +7120,95 @@ void initOpenGL() {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
+    // Malha do caminho: enviada em drawPath() quando pathMeshDirty
+    glGenVertexArrays(1, &pathVAO);
+    glGenBuffers(1, &pathVBO);
+    glBindVertexArray(pathVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, pathVBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    pathMeshDirty = true;
+
+    // Overlay de posicionamento: quad com posição e coordenada de textura
+    overlayShaderProgram = createAndLinkShaderProgram(overlayVertexShaderSource, overlayFragmentShaderSource);
+    glGenVertexArrays(1, &overlayVAO);
+    glGenBuffers(1, &overlayVBO);
+    glBindVertexArray(overlayVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, overlayVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    glGenTextures(1, &placementTexture);
+    glBindTexture(GL_TEXTURE_2D, placementTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
     // Inicializar renderização de texto (já faz seu próprio shader, VAO, VBO)
     initTextRendering();
 
+    // Partículas de impacto e morte (desligadas se o driver não suportar)
+    initParticleSystem();
+
     // Definir cor de fundo inicial (será sobrescrita em render())
     glClearColor(0.1f, 0.12f, 0.15f, 1.0f);
 }
 
 // Implementação das funções que estavam faltando
 void drawPath() {
-    for (size_t i = 0; i < path.size() - 1; ++i) {
-        drawLine(path[i], path[i+1], COLOR_PATH, 5.0f); // Usar nova cor e espessura
+    if (simConfig.mazeMode) {
+        // Sem caminho fixo: marca a entrada e a coluna de saída
+        drawCircle(path.front().x, path.front().y, 12.0f, COLOR_PATH);
+        drawRectangle(WINDOW_WIDTH - (float)flowField.cellSize, 0.0f, (float)flowField.cellSize, (float)WINDOW_HEIGHT,
+                      Color(COLOR_PATH.r, COLOR_PATH.g, COLOR_PATH.b, 0.5f));
+        return;
+    }
+    glUseProgram(shaderProgram);
+    setProjectionMatrix(shaderProgram);
+    int colorLoc = glGetUniformLocation(shaderProgram, "color");
+    glUniform4f(colorLoc, COLOR_PATH.r, COLOR_PATH.g, COLOR_PATH.b, COLOR_PATH.a);
+
+    glBindVertexArray(pathVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, pathVBO);
+    if (pathMeshDirty) {
+        glBufferData(GL_ARRAY_BUFFER, pathMeshVertices.size() * sizeof(float), pathMeshVertices.data(), GL_STATIC_DRAW);
+        pathMeshDirty = false;
+    }
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, (GLsizei)(pathMeshVertices.size() / 2));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+// Desenha um trecho do caminho, quebrando nas quinas
+void drawPathInterval(const PathInterval& interval, Color color, float width) {
+    for (size_t i = pathSegmentAt(std::max(0.0f, interval.start)); i + 1 < path.size() && pathLengths[i] < interval.end; i++) {
+        float start = std::max(interval.start, pathLengths[i]);
+        float end = std::min(interval.end, pathLengths[i + 1]);
+        if (start < end) {
+            drawLine(pathPointAt(start), pathPointAt(end), color, width);
+        }
     }
 }
 
-void drawEnemy(const Enemy& enemy) {
+void drawEnemy(const Enemy& enemy, float health) {
+    const EnemyKindTraits& traits = enemyKinds[enemy.kind];
+    if (traits.flying) {
+        // Sombra deslocada: o inimigo voa por cima do mapa
+        drawCircle(enemy.position.x + 4.0f, enemy.position.y - 6.0f, enemy.radius * 0.8f, Color(0.0f, 0.0f, 0.0f, 0.35f));
+    }
+    if (traits.armor > 0.0f) {
+        drawCircle(enemy.position.x, enemy.position.y, enemy.radius + 3.0f, Color(0.45f, 0.45f, 0.5f)); // Blindagem
+    }
     drawCircle(enemy.position.x, enemy.position.y, enemy.radius, enemy.color);
     // Barra de vida
-    float healthPercentage = enemy.health / enemy.maxHealth;
+    float healthPercentage = health / enemy.maxHealth;
     float barWidth = enemy.radius * 1.5f;
     float barHeight = 5.0f;
     float barX = enemy.position.x - barWidth / 2.0f;
@@ -1240,9 +7224,10 @@ void drawTower(const Tower& tower) {
     float platformOffsetY = tower.radius * 0.3f; // Deslocamento Y para o topo
 
     // Cor da base (um pouco mais escura)
-    Color baseColor = Color(tower.color.r * 0.8f, tower.color.g * 0.8f, tower.color.b * 0.8f, tower.color.a);
+    const Color& color = towerTypes[tower.type].color;
+    Color baseColor = Color(color.r * 0.8f, color.g * 0.8f, color.b * 0.8f, color.a);
     // Cor do topo (cor original)
-    Color topColor = tower.color;
+    Color topColor = color;
 
     // Desenhar a base hexagonal
     drawHexagon(tower.position.x, tower.position.y - platformOffsetY / 2, baseRadius, baseColor);
@@ -1256,54 +7241,90 @@ void drawTower(const Tower& tower) {
 
 
     // Desenhar alcance (círculo) se a torre estiver selecionada ou o mouse estiver sobre ela (simplificado aqui)
-    // if (placingTowerType.empty() && /* mouse over tower, ou torre selecionada */ ) {
+    // if (placingTowerType == NO_TOWER_TYPE && /* mouse over tower, ou torre selecionada */ ) {
     //     // ... código para desenhar alcance ...
     // }
 }
 
-void drawProjectile(const Projectile& projectile) {
+// Desenha o raster de ocupação como textura; só reenvia os dados quando o raster mudou
+void drawPlacementOverlay() {
+    glBindTexture(GL_TEXTURE_2D, placementTexture);
+    if (placementGrid.textureDirty) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, placementGrid.columns, placementGrid.rows, 0,
+                     GL_RED, GL_UNSIGNED_BYTE, placementGrid.cells.data());
+        placementGrid.textureDirty = false;
+    }
+
+    // O raster cobre um múltiplo inteiro de células, que pode passar um pouco da janela
+    float w = (float)(placementGrid.columns * placementGrid.cellSize);
+    float h = (float)(placementGrid.rows * placementGrid.cellSize);
+    float vertices[6][4] = {
+        { 0.0f, h,    0.0f, 1.0f },
+        { 0.0f, 0.0f, 0.0f, 0.0f },
+        { w,    0.0f, 1.0f, 0.0f },
+
+        { 0.0f, h,    0.0f, 1.0f },
+        { w,    0.0f, 1.0f, 0.0f },
+        { w,    h,    1.0f, 1.0f }
+    };
+
+    glUseProgram(overlayShaderProgram);
+    setProjectionMatrix(overlayShaderProgram);
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(glGetUniformLocation(overlayShaderProgram, "occupancy"), 0);
+
+    glBindVertexArray(overlayVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, overlayVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void drawProjectile(const Projectile& projectile, Point position) {
     // Projétil com um pequeno brilho/rastro (simulado com dois círculos)
-    drawCircle(projectile.position.x, projectile.position.y, projectile.radius, projectile.color);
-    drawCircle(projectile.position.x, projectile.position.y, projectile.radius * 0.5f, Color(1.0f, 1.0f, 1.0f, 0.8f)); // Miolo branco
+    drawCircle(position.x, position.y, projectile.radius, projectile.color);
+    drawCircle(position.x, position.y, projectile.radius * 0.5f, Color(1.0f, 1.0f, 1.0f, 0.8f)); // Miolo branco
 }
 
 void drawUI() {
+    PROFILE_ZONE("drawUI");
+    AllocationScope allocationScope(ALLOC_SCOPE_UI);
     float uiMargin = 20.0f;
     float lineHeight = 30.0f; // Aumentado de 25.0f para 30.0f
     float currentY = WINDOW_HEIGHT - uiMargin - lineHeight;
     float scale = 0.8f; // Aumentado de 0.45f para 0.8f para textos maiores
 
-    // Informações do Jogador (Canto Superior Esquerdo)
-    std::stringstream moneyStream, livesStream, waveStream;
-    moneyStream << std::fixed << std::setprecision(0) << money;
-    RenderText("Dinheiro: " + moneyStream.str(), uiMargin, currentY, scale, COLOR_TEXT_UI);
+    // Informações do Jogador (Canto Superior Esquerdo); textos formatados na arena do frame
+    RenderText(frameFormat("Dinheiro: %.0f", money), uiMargin, currentY, scale, COLOR_TEXT_UI);
     currentY -= lineHeight;
-    RenderText("Vidas: " + std::to_string(lives), uiMargin, currentY, scale, COLOR_TEXT_UI);
+    RenderText(frameFormat("Vidas: %d", lives), uiMargin, currentY, scale, COLOR_TEXT_UI);
     currentY -= lineHeight;
-    RenderText("Onda: " + std::to_string(currentWave), uiMargin, currentY, scale, COLOR_TEXT_UI);
+    RenderText(frameFormat("Onda: %d", currentWave), uiMargin, currentY, scale, COLOR_TEXT_UI);
 
     // Botões de Torre (Inferior Central)
     float buttonWidth = 180.0f; // Aumentado de 150.0f para 180.0f
     float buttonHeight = 50.0f; // Aumentado de 40.0f para 50.0f
     float buttonSpacing = 25.0f; // Aumentado de 20.0f para 25.0f
-    float totalButtonWidth = (towerTypes.size() * buttonWidth) + ((towerTypes.size() - 1) * buttonSpacing);
+    float totalButtonWidth = (TOWER_TYPE_COUNT * buttonWidth) + ((TOWER_TYPE_COUNT - 1) * buttonSpacing);
     float startX = (WINDOW_WIDTH - totalButtonWidth) / 2.0f;
     float buttonY = uiMargin + buttonHeight; // Posição Y a partir da base
     
     // Calcular textY fora do loop para que esteja disponível para todos os botões
     float textY = buttonY - buttonHeight / 2.0f - (Characters['A'].Size.y * scale / 3.0f); // Ajuste para centralizar
 
-    int i = 0;
-    for (const auto& pair : towerTypes) {
-        float currentButtonX = startX + i * (buttonWidth + buttonSpacing);
-        Color buttonColor = (placingTowerType == pair.first) ? COLOR_BUTTON_SELECTED : COLOR_BUTTON_NORMAL;
+    for (int type = 0; type < TOWER_TYPE_COUNT; type++) {
+        float currentButtonX = startX + type * (buttonWidth + buttonSpacing);
+        Color buttonColor = (placingTowerType == type) ? COLOR_BUTTON_SELECTED : COLOR_BUTTON_NORMAL;
         
         drawRectangle(currentButtonX, buttonY - buttonHeight, buttonWidth, buttonHeight, buttonColor); // Y ajustado para desenhar para cima
         
-        std::string buttonText = pair.second.name + " ($ " + std::to_string(static_cast<int>(pair.second.cost)) + ")";
+        std::string_view buttonText = frameFormat("%s ($ %d)", towerTypes[type].name, static_cast<int>(towerTypes[type].cost));
         // Centralizar texto no botão
         RenderText(buttonText, currentButtonX + 15.0f, textY, scale, COLOR_TEXT_UI);
-        i++;
     }
     
     // Botão Iniciar Onda (Canto Inferior Direito)
@@ -1314,8 +7335,7 @@ void drawUI() {
     }
 
     // Mensagem de Feedback (Centralizada na parte superior)
-    if (feedbackTimer > 0.0f) {
-        feedbackTimer -= 1.0f / 60.0f; // Assumindo 60 FPS, ajuste se necessário
+    if (feedbackVisible) {
         float feedbackTextWidth = 0; // Precisaria de uma função para medir o texto
         // Simulação da largura do texto para centralização
         for(char c : currentFeedback) feedbackTextWidth += (Characters[c].Advance >> 6) * scale;
@@ -1341,17 +7361,17 @@ void drawUI() {
         float textScaleLarge = 1.2f; // Aumentado de 0.8f para 1.2f
         float textScaleMedium = 0.9f; // Aumentado de 0.5f para 0.9f
         
-        std::string gameOverText = "Fim de Jogo!";
+        std::string_view gameOverText = "Fim de Jogo!";
         float textX = gameOverBgX + (gameOverBgWidth - gameOverText.length() * 15 * textScaleLarge) / 2.0f; // Aproximação da largura
         float textY = gameOverBgY + gameOverBgHeight - 70.0f; // Ajustado de 60.0f para 70.0f
         RenderText(gameOverText, textX, textY, textScaleLarge, Color(1.0f, 0.3f, 0.3f));
 
-        std::string waveReachedText = "Você alcançou a onda: " + std::to_string(currentWave);
+        std::string_view waveReachedText = frameFormat("Você alcançou a onda: %d", currentWave);
         textX = gameOverBgX + (gameOverBgWidth - waveReachedText.length() * 15 * textScaleMedium) / 2.0f;
         textY -= 60.0f; // Aumentado de 50.0f para 60.0f
         RenderText(waveReachedText, textX, textY, textScaleMedium, COLOR_TEXT_UI);
 
-        std::string restartText = "Pressione R para reiniciar";
+        std::string_view restartText = "Pressione R para reiniciar";
         textX = gameOverBgX + (gameOverBgWidth - restartText.length() * 15 * textScaleMedium) / 2.0f;
         textY -= 50.0f; // Aumentado de 40.0f para 50.0f
         RenderText(restartText, textX, textY, textScaleMedium, COLOR_TEXT_UI);